@@ -0,0 +1,103 @@
+#
+# power-meter - Arduino Power Meter Modbus Client
+# Copyright 2026  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# PlatformIO "budget" target: reports flash and static RAM usage against the
+# environment's budget (custom_flash_budget/custom_ram_budget, defaulting to
+# the board's limits) with custom_stack_reserve bytes of RAM kept for the
+# stack, and lists the largest stack frames (from -fstack-usage).
+#
+# The stack high-water mark can only be measured at runtime; the firmware
+# logs it as "# Unused stack: N bytes".
+
+import glob
+import os
+import re
+import subprocess
+
+Import("env")
+
+STACK_FRAMES = 10
+
+def section_sizes(elf):
+	output = subprocess.check_output([env.subst("$SIZETOOL"), "-A", elf], universal_newlines=True)
+	return output.splitlines()
+
+def total(lines, regexp):
+	pattern = re.compile(regexp)
+	size = 0
+	for line in lines:
+		match = pattern.search(line)
+		if match:
+			size += int(match.group(1))
+	return size
+
+def option(name, default):
+	value = env.GetProjectOption(name, "")
+	return int(value) if value else default
+
+def stack_frames(build_dir):
+	frames = []
+	for filename in glob.glob(os.path.join(build_dir, "**", "*.su"), recursive=True):
+		with open(filename, "r") as f:
+			for line in f:
+				fields = line.rstrip("\n").split("\t")
+				if len(fields) == 3:
+					frames.append((int(fields[1]), fields[2], fields[0].split(":", 3)[-1]))
+	return sorted(frames, reverse=True)[0:STACK_FRAMES]
+
+def report(target, source, env):
+	board = env.BoardConfig()
+	lines = section_sizes(env.subst("$BUILD_DIR/${PROGNAME}.elf"))
+	flash = total(lines, env["SIZEPROGREGEXP"])
+	ram = total(lines, env["SIZEDATAREGEXP"])
+
+	flash_budget = option("custom_flash_budget", int(board.get("upload.maximum_size", 0)))
+	ram_budget = option("custom_ram_budget", int(board.get("upload.maximum_ram_size", 0)))
+	stack_reserve = option("custom_stack_reserve", 0)
+	ok = True
+
+	def line(name, used, budget):
+		nonlocal ok
+		if budget:
+			print("{0:<12} {1:>8} / {2:>8} bytes ({3:5.1f}%){4}".format(name, used, budget, used * 100 / budget, "" if used <= budget else "  OVER BUDGET"))
+			ok = ok and used <= budget
+		else:
+			print("{0:<12} {1:>8} bytes".format(name, used))
+
+	print("Environment  {0}".format(env["PIOENV"]))
+	line("Flash", flash, flash_budget)
+	line("Static RAM", ram, ram_budget - stack_reserve if ram_budget else 0)
+	if ram_budget:
+		print("{0:<12} {1:>8} bytes available for the stack and heap ({2} reserved)".format("Free RAM", ram_budget - ram, stack_reserve))
+		ok = ok and ram_budget - ram >= stack_reserve
+
+	frames = stack_frames(env.subst("$BUILD_DIR"))
+	if frames:
+		print()
+		print("Largest stack frames:")
+		for (size, qualifier, function) in frames:
+			print("{0:>8} {1:<16} {2}".format(size, qualifier, function))
+
+	if not ok:
+		return 1
+
+env.AddCustomTarget(
+	name="budget",
+	dependencies="$BUILD_DIR/${PROGNAME}.elf",
+	actions=report,
+	title="Budget",
+	description="Report flash, static RAM and stack usage against the budget")
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+#
+# power-meter - Arduino Power Meter Modbus Client
+# Copyright 2026  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+import argparse
+import configparser
+import os
+import re
+import subprocess
+import sys
+
+BUILDS = (("virtual", ""), ("static", "-DPOWER_METER_STATIC"))
+SIZES = ("Flash", "Static RAM")
+
+def environments(path):
+	config = configparser.ConfigParser(interpolation=None)
+	config.read([os.path.join(path, "platformio.ini"), os.path.join(path, "pio_local.ini")])
+	return [section[4:] for section in config.sections() if section.startswith("env:")]
+
+def build(path, env, flags):
+	environ = dict(os.environ)
+	environ["PLATFORMIO_BUILD_FLAGS"] = " ".join(filter(None, [environ.get("PLATFORMIO_BUILD_FLAGS"), flags]))
+	result = subprocess.run(["pio", "run", "-d", path, "-e", env, "-t", "budget"], env=environ,
+		stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+
+	sizes = {}
+	for line in result.stdout.splitlines():
+		match = re.match(r"^(" + "|".join(SIZES) + r")\s+(\d+)", line)
+		if match:
+			sizes[match.group(1)] = int(match.group(2))
+
+	if len(sizes) != len(SIZES):
+		sys.stdout.write(result.stdout)
+		raise RuntimeError("Build of {0} {1} failed".format(env, flags))
+	return sizes
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Compare the size of virtual and statically composed firmware builds")
+	parser.add_argument("-d", "--directory", metavar="PATH", type=str, default=os.path.dirname(os.path.abspath(__file__)), help="PlatformIO project directory")
+	parser.add_argument("-e", "--environment", metavar="ENV", type=str, action="append", help="environment to build (default: all)")
+	args = parser.parse_args()
+
+	print("{0:<24} {1:<12} {2:>8} {3:>8} {4:>8}".format("Environment", "Size", *[name for (name, flags) in BUILDS], "Change"))
+	for env in args.environment or environments(args.directory):
+		results = [build(args.directory, env, flags) for (name, flags) in BUILDS]
+		for size in SIZES:
+			print("{0:<24} {1:<12} {2:>8} {3:>8} {4:>+8}".format(env, size, *[result[size] for result in results], results[1][size] - results[0][size]))
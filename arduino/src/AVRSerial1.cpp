@@ -0,0 +1,84 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AVRSerial1.hpp"
+
+#ifdef __AVR__
+AVRSerial1 avrSerial1;
+RS485 *AVRSerial1::receiver_ = nullptr;
+
+AVRSerial1::AVRSerial1() {
+
+}
+
+AVRSerial1::~AVRSerial1() {
+
+}
+
+void AVRSerial1::begin(unsigned long baudRate, RS485 &receiver) {
+	noInterrupts();
+	receiver_ = &receiver;
+	UCSR1B = 0;
+	UCSR1A = _BV(U2X1);
+	UBRR1 = (F_CPU / 4 / baudRate - 1) / 2;
+	UCSR1C = _BV(UCSZ11) | _BV(UCSZ10); // 8N1
+	UCSR1B = _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+	interrupts();
+}
+
+int AVRSerial1::available() {
+	return 0;
+}
+
+int AVRSerial1::read() {
+	return -1;
+}
+
+int AVRSerial1::peek() {
+	return -1;
+}
+
+size_t AVRSerial1::write(uint8_t data) {
+	while (!(UCSR1A & _BV(UDRE1)));
+
+	// Clear the transmit complete flag (by writing a 1 to it)
+	UCSR1A = (UCSR1A & (_BV(U2X1) | _BV(MPCM1))) | _BV(TXC1);
+	UDR1 = data;
+	written_ = true;
+	return 1;
+}
+
+void AVRSerial1::flush() {
+	if (written_) {
+		while (!(UCSR1A & _BV(TXC1)));
+		written_ = false;
+	}
+}
+
+void AVRSerial1::receiveInterrupt() {
+	uint8_t status = UCSR1A;
+	uint8_t data = UDR1;
+
+	if (receiver_ != nullptr) {
+		receiver_->receive(data, micros(), status & (_BV(FE1) | _BV(DOR1) | _BV(UPE1)));
+	}
+}
+
+ISR(USART1_RX_vect) {
+	AVRSerial1::receiveInterrupt();
+}
+#endif
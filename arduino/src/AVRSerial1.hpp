@@ -0,0 +1,59 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef POWER_METER_AVRSERIAL1_HPP
+#define POWER_METER_AVRSERIAL1_HPP
+
+#ifdef __AVR__
+#include <stdint.h>
+#include <Arduino.h>
+
+#include "RS485.hpp"
+
+/**
+USART1 driver that passes each received byte (with the time it was
+received) directly to RS485 from the receive interrupt, instead of
+using the core's 64-byte buffer (Serial1 must not be used with this).
+
+Transmit is not buffered, and flush() waits for the transmit complete
+flag so that the transmitter can be disabled as soon as the last stop
+bit has been sent.
+*/
+class AVRSerial1 final: public Stream {
+public:
+	AVRSerial1();
+	virtual ~AVRSerial1();
+	void begin(unsigned long baudRate, RS485 &receiver);
+
+	int available() override;
+	int read() override;
+	int peek() override;
+	size_t write(uint8_t data) override;
+	void flush() override;
+	using Print::write;
+
+	static void receiveInterrupt();
+
+private:
+	static RS485 *receiver_;
+	bool written_ = false; ///< Data has been written since the last flush
+};
+
+extern AVRSerial1 avrSerial1;
+#endif
+
+#endif
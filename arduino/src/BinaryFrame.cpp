@@ -0,0 +1,136 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BinaryFrame.hpp"
+#include "CRC16.hpp"
+
+BinaryFrame::BinaryFrame() : length_(0), overflow_(false) {
+
+}
+
+void BinaryFrame::add(uint8_t value) {
+	if (length_ < MAX_LENGTH) {
+		buffer_[length_++] = value;
+	} else {
+		overflow_ = true;
+	}
+}
+
+void BinaryFrame::add(uint16_t value) {
+	add((uint8_t)value);
+	add((uint8_t)(value >> 8));
+}
+
+void BinaryFrame::add(uint32_t value) {
+	add((uint16_t)value);
+	add((uint16_t)(value >> 16));
+}
+
+void BinaryFrame::add(const char *value) {
+	size_t length = strlen(value);
+
+	if (length > UINT8_MAX) {
+		length = UINT8_MAX;
+	}
+
+	add((uint8_t)length);
+	for (size_t i = 0; i < length; i++) {
+		add((uint8_t)value[i]);
+	}
+}
+
+void BinaryFrame::add(const String &value) {
+	add(value.c_str());
+}
+
+void BinaryFrame::add(const __FlashStringHelper *value) {
+	PGM_P text = reinterpret_cast<PGM_P>(value);
+	size_t length = strlen_P(text);
+
+	if (length > UINT8_MAX) {
+		length = UINT8_MAX;
+	}
+
+	add((uint8_t)length);
+	for (size_t i = 0; i < length; i++) {
+		add((uint8_t)pgm_read_byte(text + i));
+	}
+}
+
+size_t BinaryFrame::writeTo(Print &p) const {
+	CRC16 crc;
+	uint8_t trailer[2];
+	size_t length = length_ + sizeof(trailer);
+	size_t n = 0;
+	size_t pos = 0;
+
+	if (overflow_) {
+		return 0;
+	}
+
+	// The CRC is written after the frame without being added to it, so
+	// that the same frame can be written more than once
+	crc.update(buffer_, length_);
+	trailer[0] = crc.value() & 0xFF;
+	trailer[1] = crc.value() >> 8;
+
+	n += p.write(DELIMITER);
+
+	while (true) {
+		size_t run = 0;
+
+		while (pos + run < length && byteAt(pos + run, trailer) != 0 && run < MAX_BLOCK) {
+			run++;
+		}
+
+		n += p.write((uint8_t)(run + 1));
+		if (pos < length_) {
+			size_t count = pos + run <= length_ ? run : length_ - pos;
+
+			n += p.write(&buffer_[pos], count);
+			if (run > count) {
+				n += p.write(trailer, run - count);
+			}
+		} else {
+			n += p.write(&trailer[pos - length_], run);
+		}
+		pos += run;
+
+		if (pos >= length) {
+			break;
+		}
+
+		if (run < MAX_BLOCK) {
+			// Skip the zero byte (implied by the block length)
+			pos++;
+
+			if (pos == length) {
+				n += p.write((uint8_t)1);
+				break;
+			}
+		}
+	}
+
+	n += p.write(DELIMITER);
+
+	return n;
+}
+
+uint8_t BinaryFrame::byteAt(size_t pos, const uint8_t trailer[]) const {
+	return pos < length_ ? buffer_[pos] : trailer[pos - length_];
+}
@@ -0,0 +1,70 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_BINARYFRAME_HPP
+#define POWER_METER_BINARYFRAME_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+/**
+Binary reading frame (values are Little-endian):
+	8-bit Version (1, or 2 with the bus and address)
+	16-bit Sequence number
+	8-bit Model length, followed by the model
+	8-bit Serial number length, followed by the serial number
+	Version 2 only:
+		8-bit RS485 bus
+		8-bit Modbus address
+	16-bit Bitmap of values present (bit 0 = voltage ... bit 9 = reactiveEnergy)
+	16-bit Bitmap of values with a signed coefficient
+	For each value present:
+		8-bit Exponent (signed)
+		32-bit Coefficient
+	16-bit CRC-16/MODBUS of all previous bytes
+
+The frame is COBS encoded and written between 0x00 delimiters.
+*/
+class BinaryFrame {
+public:
+	BinaryFrame();
+	void add(uint8_t value);
+	void add(uint16_t value);
+	void add(uint32_t value);
+	void add(const char *value);
+	void add(const String &value);
+	void add(const __FlashStringHelper *value);
+	size_t writeTo(Print &p) const __attribute__((warn_unused_result));
+
+	static constexpr uint8_t VERSION = 1;
+	static constexpr uint8_t VERSION_BUS = 2;
+	static constexpr size_t MAX_LENGTH = 128;
+
+private:
+	uint8_t byteAt(size_t pos, const uint8_t trailer[]) const;
+
+	static constexpr uint8_t DELIMITER = 0x00;
+	static constexpr size_t MAX_BLOCK = 254;
+
+	uint8_t buffer_[MAX_LENGTH];
+	size_t length_;
+	bool overflow_;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_CRC16_HPP
+#define POWER_METER_CRC16_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+CRC-16/MODBUS (polynomial 0x8005 reflected, initial value 0xFFFF)
+
+The CRC is calculated a byte at a time using a 256-entry table in flash,
+or with -DPOWER_METER_CRC16_NIBBLE using a 16-entry table (half a byte
+at a time) to save flash. It can be updated as each byte arrives.
+
+For a received frame, updating the CRC with the frame's own CRC (low
+byte first) results in a value of 0.
+
+This is used for BinaryFrame and the responses generated by RS485 on a
+timeout. ModbusMaster has its own CRC function for Modbus transactions.
+*/
+class CRC16 {
+public:
+	CRC16();
+	void reset();
+	void update(uint8_t data);
+	void update(const uint8_t *data, size_t length);
+	uint16_t value() const;
+	bool valid() const;
+
+	static uint16_t update(uint16_t crc, uint8_t data);
+	static uint16_t updateBitwise(uint16_t crc, uint8_t data);
+	static uint16_t updateNibble(uint16_t crc, uint8_t data);
+	static uint16_t updateTable(uint16_t crc, uint8_t data);
+
+	static constexpr uint16_t INITIAL = 0xFFFF;
+
+private:
+	static constexpr uint16_t POLYNOMIAL = 0xA001;
+
+	uint16_t crc_;
+};
+
+#endif
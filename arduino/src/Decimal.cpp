@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017,2025  Simon Arlott
+ * Copyright 2017,2025-2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -64,6 +64,14 @@ uint32_t Decimal::coefficient() const {
 	return coefficient_;
 }
 
+bool Decimal::coefficientSigned() const {
+	return coefficientSigned_;
+}
+
+int8_t Decimal::exponent() const {
+	return exponent_;
+}
+
 size_t Decimal::printTo(Print &p) const {
 	size_t n = 0;
 
@@ -73,7 +81,7 @@ size_t Decimal::printTo(Print &p) const {
 		n += p.print(coefficient_);
 	}
 
-	n += p.print(".0");
+	n += p.print(F(".0"));
 
 	if (exponent_) {
 		n += p.print('e');
@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017,2025  Simon Arlott
+ * Copyright 2017,2025-2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -34,6 +34,8 @@ public:
 	virtual ~Decimal();
 	bool hasValue() const;
 	uint32_t coefficient() const;
+	bool coefficientSigned() const;
+	int8_t exponent() const;
 	virtual size_t printTo(Print &p) const __attribute__((warn_unused_result));
 
 private:
@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017,2022  Simon Arlott
+ * Copyright 2017,2022,2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -27,12 +27,14 @@
 #include "Main.hpp"
 #include "EthernetNetwork.hpp"
 #include "Settings.hpp"
+#include "WebPage.hpp"
 
 #ifdef ARDUINO_ARCH_ESP8266
 # include <EEPROM.h>
 # include <ESP8266WiFi.h>
 # include <IPAddress.h>
 # include <WiFiUdp.h>
+# include <lwip/dns.h>
 extern "C" {
 	#include <user_interface.h>
 }
@@ -41,14 +43,46 @@ extern "C" {
 #ifdef POWER_METER_HAS_NETWORK
 EthernetNetwork ethernetNetwork;
 
+#ifdef ARDUINO_ARCH_ESP8266
+#define PAGE_HEADER "<!DOCTYPE html>" \
+	"<html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"></head><body>"
+#define PAGE_FOOTER "</body></html>"
+
+// Fields in the configuration page template
+#define FIELD_ID "\x01"
+#define FIELD_SSID "\x02"
+#define FIELD_PASSPHRASE "\x03"
+#define FIELD_NTP_HOSTNAME "\x04"
+
+static const char CONFIG_PAGE_HEADER[] PROGMEM = PAGE_HEADER "<form method=\"POST\" action=\"/save\">";
+static const char CONFIG_PAGE_NETWORK[] PROGMEM =
+	"SSID " FIELD_ID ": <input type=\"text\" name=\"ssid_" FIELD_ID "\" value=\"" FIELD_SSID "\"><br>"
+	"Passphrase " FIELD_ID ": <input type=\"text\" name=\"passphrase_" FIELD_ID "\" value=\"" FIELD_PASSPHRASE "\"><br>"
+	"NTP Hostname " FIELD_ID ": <input type=\"text\" name=\"ntphostname_" FIELD_ID "\" value=\"" FIELD_NTP_HOSTNAME "\"><hr>";
+static const char CONFIG_PAGE_FOOTER[] PROGMEM = "<input type=\"submit\" value=\"Save\"></form>" PAGE_FOOTER;
+
+static const WebPage::Section CONFIG_PAGE[] = {
+	{ CONFIG_PAGE_HEADER, 1 },
+	{ CONFIG_PAGE_NETWORK, Settings::MAX_NETWORKS },
+	{ CONFIG_PAGE_FOOTER, 1 },
+};
+
+static const char SAVE_PAGE[] PROGMEM = PAGE_HEADER "<p>Settings updated</p>" PAGE_FOOTER;
+static const char RESET_PAGE[] PROGMEM = PAGE_HEADER "<form method=\"POST\" action=\"/reset\">"
+	"Password: <input type=\"number\" name=\"password\" min=\"0\" max=\"4294967295\"><br>"
+	"<input type=\"submit\"></form>" PAGE_FOOTER;
+static const char RESET_SUCCESS_PAGE[] PROGMEM = PAGE_HEADER "<p>Meter reset successful</p>" PAGE_FOOTER;
+static const char RESET_FAILURE_PAGE[] PROGMEM = PAGE_HEADER "<p>Meter reset failed</p>" PAGE_FOOTER;
+#endif
+
 EthernetNetwork::EthernetNetwork() {
 	ntpSocket.begin(NTP_PORT);
 
 #ifdef ARDUINO_ARCH_ESP8266
-	webServer.on("/", webServerRootPage);
-	webServer.on("/config", webServerConfigPage);
-	webServer.on("/save", webServerSavePage);
-	webServer.on("/reset", webServerResetPage);
+	webServer.on("/", HTTP_GET, webServerRootPage);
+	webServer.on("/config", HTTP_GET, webServerConfigPage);
+	webServer.on("/save", HTTP_POST, webServerSavePage);
+	webServer.on("/reset", HTTP_ANY, webServerResetPage);
 	webServer.begin();
 #endif
 }
@@ -85,6 +119,13 @@ void EthernetNetwork::sendPacket() {
 
 			if (len == bufferLength) {
 				ret = udp.endPacket();
+
+				if (ret == 1 && !firstPacketMillis) {
+					firstPacketMillis = millis();
+					output->print(F("# First reading published after "));
+					output->print(firstPacketMillis);
+					output->println(F(" ms"));
+				}
 			}
 		}
 #endif
@@ -132,7 +173,7 @@ void EthernetNetwork::configureNetwork() {
 
 	snprintf(hostname, sizeof(hostname), HOSTNAME, ESP.getChipId());
 	wifi_station_set_hostname(hostname);
-	output->print("# Hostname = ");
+	output->print(F("# Hostname = "));
 	output->println(hostname);
 
 	if (mode == Mode::CONFIGURE) {
@@ -140,14 +181,14 @@ void EthernetNetwork::configureNetwork() {
 		//uint8_t mode = 0;
 
 		if (staEnabled) {
-			output->println("# Disconnecting WiFi STA");
+			output->println(F("# Disconnecting WiFi STA"));
 			WiFi.disconnect(true);
 			staEnabled = false;
 		}
 
 		snprintf(ssid, sizeof(ssid), SSID, ESP.getChipId());
 
-		output->println("# Enabling WiFi AP");
+		output->println(F("# Enabling WiFi AP"));
 		WiFi.mode(WIFI_AP);
 		WiFi.softAP(ssid);
 		apEnabled = true;
@@ -155,57 +196,172 @@ void EthernetNetwork::configureNetwork() {
 		//wifi_softap_set_dhcps_offer_option(OFFER_ROUTER, &mode);
 	} else {
 		if (apEnabled) {
-			output->println("# Disabling WiFi AP");
+			output->println(F("# Disabling WiFi AP"));
 			WiFi.softAPdisconnect(true);
 			apEnabled = false;
 		}
 
-		output->println("# Connecting WiFi STA");
+		output->println(F("# Connecting WiFi STA"));
 		WiFi.mode(WIFI_STA);
 
-		unsigned int n = WiFi.scanNetworks();
-		output->print("# WiFi scan found ");
-		output->print(n);
-		output->println(" networks");
+		if (!staEnabled) {
+			if (!connectLastNetwork()) {
+				scanNetworks();
+			}
+			staEnabled = true;
+		}
+	}
+#endif
+}
 
-		for (unsigned int i = 0; i < n; i++) {
-			bool found = false;
+#ifdef ARDUINO_ARCH_ESP8266
+bool EthernetNetwork::connectLastNetwork() {
+	unsigned int id;
+	uint8_t bssid[Settings::BSSID_LEN];
+	int32_t channel;
 
-			for (unsigned int j = 0; j < Settings::MAX_NETWORKS; j++) {
-				if (WiFi.SSID(i) == Settings::readWiFiSSID(j)) {
-					found = true;
+	if (!Settings::readLastConnection(id, bssid, channel)) {
+		return false;
+	}
 
-					output->print("# Found known network ");
-					output->print(WiFi.SSID(i));
-					output->print(" (");
-					output->print(WiFi.RSSI(i));
-					output->println(")");
+	output->print(F("# Reconnecting to network "));
+	output->print(Settings::readWiFiSSID(id));
+	output->print(F(" on channel "));
+	output->println(channel);
 
-					if (!staEnabled) {
-						output->print("# Connecting to network ");
-						output->println(WiFi.SSID(i));
+	ntpHostname = Settings::readNTPHostname(id);
+	network = id;
+	fastConnect = true;
+	connectStart = millis();
 
-						ntpHostname = Settings::readNTPHostname(j);
+	// Skip the scan by specifying the access point; the address is always
+	// obtained using DHCP because the previous lease could have expired
+	WiFi.begin(Settings::readWiFiSSID(id), Settings::readWiFiPassphrase(id), channel, bssid);
+	return true;
+}
 
-						WiFi.begin(Settings::readWiFiSSID(j), Settings::readWiFiPassphrase(j));
-						staEnabled = true;
-					}
+void EthernetNetwork::scanNetworks() {
+	output->println(F("# Scanning for WiFi networks"));
+	WiFi.scanNetworks(true);
+	scanning = true;
+}
 
-					break;
-				}
-			}
+bool EthernetNetwork::connectKnownNetwork() {
+	bool connecting = false;
+	int8_t n = WiFi.scanComplete();
+
+	if (n == WIFI_SCAN_RUNNING) {
+		return false;
+	}
+
+	scanning = false;
+	if (n < 0) {
+		output->println(F("# WiFi scan failed"));
+		return false;
+	}
+
+	output->print(F("# WiFi scan found "));
+	output->print(n);
+	output->println(F(" networks"));
+
+	for (int8_t i = 0; i < n; i++) {
+		bool found = false;
 
-			if (!found) {
-				output->print("# Unknown network ");
+		for (unsigned int j = 0; j < Settings::MAX_NETWORKS; j++) {
+			if (WiFi.SSID(i) == Settings::readWiFiSSID(j)) {
+				found = true;
+
+				output->print(F("# Found known network "));
 				output->print(WiFi.SSID(i));
-				output->print(" (");
+				output->print(F(" ("));
 				output->print(WiFi.RSSI(i));
-				output->println(")");
+				output->println(')');
+
+				if (!connecting) {
+					output->print(F("# Connecting to network "));
+					output->println(WiFi.SSID(i));
+
+					ntpHostname = Settings::readNTPHostname(j);
+					network = j;
+					fastConnect = false;
+					connectStart = millis();
+
+					WiFi.begin(Settings::readWiFiSSID(j), Settings::readWiFiPassphrase(j));
+					connecting = true;
+				}
+
+				break;
+			}
+		}
+
+		if (!found) {
+			output->print(F("# Unknown network "));
+			output->print(WiFi.SSID(i));
+			output->print(F(" ("));
+			output->print(WiFi.RSSI(i));
+			output->println(')');
+		}
+	}
+
+	WiFi.scanDelete();
+	return connecting;
+}
+
+void EthernetNetwork::checkConnection() {
+	uint8_t status = WiFi.status();
+
+	if (scanning) {
+		connectKnownNetwork();
+		return;
+	}
+
+	if (status == WL_CONNECTED) {
+		if (!connectedMillis) {
+			connectedMillis = millis();
+			output->print(F("# WiFi connected after "));
+			output->print(connectedMillis);
+			output->println(F(" ms"));
+		}
+
+		if (!connectionSaved && network >= 0) {
+			if (Settings::writeLastConnection(network, WiFi.BSSID(), WiFi.channel())) {
+				settingsChanged = true;
 			}
 		}
+		connectionSaved = true;
+		fastConnect = false;
+	} else {
+		connectionSaved = false;
+
+		if (fastConnect && (status == WL_NO_SSID_AVAIL || status == WL_CONNECT_FAILED
+				|| millis() - connectStart >= FAST_CONNECT_TIMEOUT)) {
+			output->println(F("# Reconnect failed, scanning for networks"));
+
+			fastConnect = false;
+			if (Settings::clearLastConnection()) {
+				settingsChanged = true;
+			}
+			WiFi.disconnect();
+			scanNetworks();
+		}
+	}
+}
+
+void EthernetNetwork::runSlowTasks() {
+	if (settingsChanged) {
+		Settings::commit();
+		settingsChanged = false;
+		return;
+	}
+
+	if (resetRequest) {
+		AsyncWebServerRequest *request = resetRequest;
+
+		resetRequest = nullptr;
+		request->send_P(200, "text/html", resetMeter(resetPassword) ? RESET_SUCCESS_PAGE : RESET_FAILURE_PAGE);
 	}
-#endif
 }
+#endif
 
 EthernetNetwork::operator bool() const {
 	if (mode == Mode::RUNNING) {
@@ -214,14 +370,14 @@ EthernetNetwork::operator bool() const {
 		uint8_t status = WiFi.status();
 
 		if (status != lastStatus) {
-			output->print("# WiFi status ");
+			output->print(F("# WiFi status "));
 			output->print(lastStatus);
-			output->print(" -> ");
+			output->print(F(" -> "));
 			output->print(status);
 			if (status == WL_CONNECTED) {
-				output->print(" (");
+				output->print(F(" ("));
 				output->print(WiFi.localIP());
-				output->println(")");
+				output->println(')');
 			} else {
 				output->println();
 			}
@@ -233,19 +389,27 @@ EthernetNetwork::operator bool() const {
 	return false;
 }
 
-void EthernetNetwork::loop() {
-	ntpMillis();
-
+void EthernetNetwork::loop(unsigned long slack) {
 #ifdef ARDUINO_ARCH_ESP8266
-	webServer.handleClient();
+	updateHeapUsage();
+
+	if (mode == Mode::RUNNING) {
+		checkConnection();
+		ntpLoop(slack);
+	}
+
+	if (slack >= SLOW_TASK_MILLIS) {
+		runSlowTasks();
+	}
 #endif
 }
 
 #ifdef ARDUINO_ARCH_ESP8266
-void EthernetNetwork::webServerRootPage() {
+void EthernetNetwork::webServerRootPage(AsyncWebServerRequest *request) {
 	unsigned long uptime = millis();
 	unsigned long days, hours, minutes, seconds, ms;
-	char response[64];
+	char response[224];
+	int length;
 
 	days = uptime / 86400000;
 	uptime %= 86400000;
@@ -261,188 +425,232 @@ void EthernetNetwork::webServerRootPage() {
 
 	ms = uptime;
 
-	snprintf(response, sizeof(response), "%03ld+%02ld:%02ld:%02ld.%03ld\n", days, hours, minutes, seconds, ms);
-	ethernetNetwork.webServer.send(200, "text/plain", response);
+	length = snprintf(response, sizeof(response), "%03ld+%02ld:%02ld:%02ld.%03ld\n", days, hours, minutes, seconds, ms);
+	if (length > 0 && (size_t)length < sizeof(response)) {
+		snprintf(response + length, sizeof(response) - length, "WiFi connected: %lu ms\nFirst reading published: %lu ms\nMaximum read lateness: %lu ms\n"
+			"Free heap: %u bytes (minimum %u, largest block %u)\n",
+			ethernetNetwork.connectedMillis, ethernetNetwork.firstPacketMillis, maxReadLateness(),
+			ESP.getFreeHeap(), ethernetNetwork.minFreeHeap, ESP.getMaxFreeBlockSize());
+	}
+	request->send(200, "text/plain", response);
 }
 
-void EthernetNetwork::webServerConfigPage() {
-	String page = "<!DOCTYPE html>"
-		"<html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"></head>"
-		"<body><form method=\"POST\" action=\"/save\">";
+const char *EthernetNetwork::configPageField(char field, unsigned int index, char *scratch, size_t size) {
+	switch (field) {
+	case FIELD_ID[0]:
+		snprintf(scratch, size, "%u", index);
+		return scratch;
 
-	for (unsigned int id = 0; id < Settings::MAX_NETWORKS; id++) {
-		page += "SSID ";
-		page += id;
-		page += ": <input type=\"text\" name=\"ssid_";
-		page += id;
-		page += "\" value=\"";
-		page += Settings::readWiFiSSID(id);
-		page += "\"><br>";
-		page += "Passphrase ";
-		page += id;
-		page += ": <input type=\"text\" name=\"passphrase_";
-		page += id;
-		page += "\" value=\"";
-		if (strlen(Settings::readWiFiSSID(id)) > 0) {
-			page += "*";
-		}
-		page += "\"><br>";
-		page += "NTP Hostname ";
-		page += id;
-		page += ": <input type=\"text\" name=\"ntphostname_";
-		page += id;
-		page += "\" value=\"";
-		page += Settings::readNTPHostname(id);
-		page += "\"><hr>";
-	}
+	case FIELD_SSID[0]:
+		return Settings::readWiFiSSID(index);
 
-	page += "<input type=\"submit\" value=\"Save\"></form></body></html>";
+	case FIELD_PASSPHRASE[0]:
+		return strlen(Settings::readWiFiSSID(index)) > 0 ? "*" : "";
+
+	case FIELD_NTP_HOSTNAME[0]:
+		return Settings::readNTPHostname(index);
+	}
 
-	ethernetNetwork.webServer.send(200, "text/html", page);
+	return nullptr;
 }
 
-void EthernetNetwork::webServerSavePage() {
-	constexpr ESP8266WebServer &server = ethernetNetwork.webServer;
+void EthernetNetwork::webServerConfigPage(AsyncWebServerRequest *request) {
+	WebPage page{CONFIG_PAGE, sizeof(CONFIG_PAGE) / sizeof(CONFIG_PAGE[0]), configPageField};
 
-	String page = "<!DOCTYPE html>"
-		"<html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"></head>"
-		"<body><p>Settings updated</p></body></html>";
+	ethernetNetwork.updateHeapUsage();
+	request->send(request->beginChunkedResponse("text/html",
+		[page] (uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+			(void)index;
+			ethernetNetwork.updateHeapUsage();
+			return page.read(buffer, maxLen);
+		}));
+}
 
-	for (unsigned int id = 0; id < Settings::MAX_NETWORKS; id++) {
-		String argName;
-		String argValue;
+void EthernetNetwork::webServerSavePage(AsyncWebServerRequest *request) {
+	char name[24];
 
- 		argName = "ssid_";
-		argName += id;
-		argValue = server.arg(argName);
-		Settings::writeWiFiSSID(id, argValue);
+	for (unsigned int id = 0; id < Settings::MAX_NETWORKS; id++) {
+		snprintf(name, sizeof(name), "ssid_%u", id);
+		const String &ssid = request->arg(name);
+		Settings::writeWiFiSSID(id, ssid);
 
-		if (argValue == "") {
+		if (ssid == "") {
 			Settings::writeWiFiPassphrase(id, "");
 			Settings::writeNTPHostname(id, "");
 		} else {
-			argName = "passphrase_";
-			argName += id;
-			argValue = server.arg(argName);
-			if (argValue != "*") {
-				Settings::writeWiFiPassphrase(id, argValue);
+			snprintf(name, sizeof(name), "passphrase_%u", id);
+			const String &passphrase = request->arg(name);
+			if (passphrase != "*") {
+				Settings::writeWiFiPassphrase(id, passphrase);
 			}
 
-			argName = "ntphostname_";
-			argName += id;
-			argValue = server.arg(argName);
-			Settings::writeNTPHostname(id, argValue);
+			snprintf(name, sizeof(name), "ntphostname_%u", id);
+			Settings::writeNTPHostname(id, request->arg(name));
 		}
 	}
-	Settings::commit();
+	ethernetNetwork.settingsChanged = true;
 
-	server.send(200, "text/html", page);
+	request->send_P(200, "text/html", SAVE_PAGE);
 }
 
-void EthernetNetwork::webServerResetPage() {
-	constexpr ESP8266WebServer &server = ethernetNetwork.webServer;
-
-	for (int i = 0; i < server.args(); i++) {
-		if (server.argName(i) == "password") {
-			String page = "<!DOCTYPE html>"
-				"<html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"></head>"
-				"<body><p>Meter reset ";
-
-			if (resetMeter((uint32_t)server.arg(i).toInt())) {
-				page += "successful";
-			} else {
-				page += "failed";
-			}
-
-			page += "</p></body></html>";
-			ethernetNetwork.webServer.send(200, "text/html", page);
+void EthernetNetwork::webServerResetPage(AsyncWebServerRequest *request) {
+	if (request->hasArg("password")) {
+		if (ethernetNetwork.resetRequest) {
+			request->send(503, "text/plain", "Meter reset already in progress\n");
 			return;
 		}
+
+		// The response is sent when the meter has been reset
+		ethernetNetwork.resetPassword = (uint32_t)request->arg("password").toInt();
+		ethernetNetwork.resetRequest = request;
+		request->onDisconnect([request] {
+			if (ethernetNetwork.resetRequest == request) {
+				ethernetNetwork.resetRequest = nullptr;
+			}
+		});
+		return;
 	}
 
-	String page = "<!DOCTYPE html>"
-		"<html><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"></head>"
-		"<body><form method=\"POST\" action=\"/reset\">"
-		"Password: <input type=\"number\" name=\"password\" min=\"0\" max=\"4294967295\"><br>"
-		"<input type=\"submit\"></form></body></html>";
+	request->send_P(200, "text/html", RESET_PAGE);
+}
 
-	ethernetNetwork.webServer.send(200, "text/html", page);
+void EthernetNetwork::updateHeapUsage() {
+	uint32_t free = ESP.getFreeHeap();
+
+	if (!minFreeHeap || free < minFreeHeap) {
+		minFreeHeap = free;
+	}
 }
 #endif
 
 bool EthernetNetwork::isTimeValid() {
-	if (!ntpValid) {
-		ntpMillis();
-	}
 	return ntpValid;
 }
 
 unsigned long EthernetNetwork::ntpMillis() {
-	static constexpr int NTP_PACKET_SIZE = 48; // NTP time stamp is in the first 48 bytes of the message
-	static unsigned long lastQuery;
-	static unsigned long offset = 0;
-	static bool ntpStart = false;
-	unsigned long interval = ntpValid ? NTP_VALID_INTERVAL : NTP_START_INTERVAL;
+	return millis() + ntpOffset;
+}
 
-	if (!ntpStart || millis() - lastQuery >= (1000UL << interval)) {
-		if (WiFi.status() == WL_CONNECTED) {
-			const char *serverName = ntpHostname;
-			IPAddress serverAddress;
+#ifdef ARDUINO_ARCH_ESP8266
+void EthernetNetwork::ntpLoop(unsigned long slack) {
+	// Retry quickly at first so that readings are aligned to the second
+	// as soon as possible, backing off if the server isn't responding
+	unsigned long interval = ntpValid ? NTP_VALID_INTERVAL : ntpRetry;
+
+	switch (ntpState) {
+	case NTPState::IDLE:
+		if (WiFi.status() == WL_CONNECTED && slack > NTP_TIMEOUT
+				&& (!ntpStart || millis() - ntpLastQuery >= (1000UL << interval))) {
+			ip_addr_t address;
+			err_t err;
 
 			if (strlen(ntpHostname) == 0) {
 				ntpHostname = NTP_DEFAULT_HOSTNAME;
 			}
 
-			if (WiFi.hostByName(serverName, serverAddress)) {
-				uint8_t packetBuffer[NTP_PACKET_SIZE];
-
-				memset(packetBuffer, 0, NTP_PACKET_SIZE);
-
-				// Initialize values needed to form NTP request
-				// https://en.wikipedia.org/wiki/Network_Time_Protocol
-				packetBuffer[0] = 0b11100011;         // LI, Version, Mode
-				packetBuffer[1] = 0;                  // Stratum, or type of clock
-				packetBuffer[2] = NTP_VALID_INTERVAL; // Polling Interval
-				packetBuffer[3] = 0xEC;               // Peer Clock Precision
-				// 8 bytes of zero for Root Delay & Root Dispersion
-				packetBuffer[12] = 49;
-				packetBuffer[13] = 0x4E;
-				packetBuffer[14] = 49;
-				packetBuffer[15] = 52;
-
-				ntpSocket.beginPacket(serverAddress, NTP_PORT);
-				ntpSocket.write(packetBuffer, NTP_PACKET_SIZE);
-				ntpSocket.endPacket();
-
-				lastQuery = millis();
-
-				while (millis() - lastQuery <= NTP_TIMEOUT) {
-					if (ntpSocket.parsePacket()) {
-						memset(packetBuffer, 0, NTP_PACKET_SIZE);
-						if (ntpSocket.read(packetBuffer, NTP_PACKET_SIZE) == NTP_PACKET_SIZE) {
-							unsigned long now = millis();
-							uint32_t fraction = word(packetBuffer[44], packetBuffer[45]) << 16 | word(packetBuffer[46], packetBuffer[47]);
-
-							fraction /= 4294967;
-							fraction += (now - lastQuery) / 2;
-							fraction %= 1000;
-							offset = fraction - now;
-
-							ntpValid = true;
-						}
-						break;
-					}
-					yield();
-				}
-			} else {
-				lastQuery = millis();
+			ntpStart = true;
+			ntpLastQuery = millis();
+			ntpState = NTPState::RESOLVING;
+
+			err = dns_gethostbyname(ntpHostname, &address, ntpResolved, this);
+			if (err == ERR_OK) {
+				ntpResolved(ntpHostname, &address, this);
+			} else if (err != ERR_INPROGRESS) {
+				ntpFailed();
 			}
+		}
+		break;
 
-			ntpStart = true;
+	case NTPState::RESOLVING:
+		if (millis() - ntpLastQuery > NTP_DNS_TIMEOUT) {
+			ntpFailed();
+		}
+		break;
+
+	case NTPState::RESOLVED:
+		if (slack > NTP_TIMEOUT) {
+			ntpSend();
+		}
+		break;
+
+	case NTPState::WAITING:
+		if (ntpSocket.parsePacket()) {
+			uint8_t packetBuffer[NTP_PACKET_SIZE];
+
+			memset(packetBuffer, 0, NTP_PACKET_SIZE);
+			if (ntpSocket.read(packetBuffer, NTP_PACKET_SIZE) == NTP_PACKET_SIZE) {
+				unsigned long now = millis();
+				uint32_t fraction = word(packetBuffer[44], packetBuffer[45]) << 16 | word(packetBuffer[46], packetBuffer[47]);
+
+				fraction /= 4294967;
+				fraction += (now - ntpLastQuery) / 2;
+				fraction %= 1000;
+				ntpOffset = fraction - now;
+
+				ntpValid = true;
+				ntpState = NTPState::IDLE;
+			} else {
+				ntpFailed();
+			}
+		} else if (millis() - ntpLastQuery > NTP_TIMEOUT) {
+			ntpFailed();
 		}
+		break;
+	}
+}
+
+void EthernetNetwork::ntpResolved(const char *name, const ip_addr_t *address, void *arg) {
+	EthernetNetwork *network = static_cast<EthernetNetwork*>(arg);
+
+	(void)name;
+	if (network->ntpState != NTPState::RESOLVING) {
+		return;
+	}
+
+	if (address) {
+		network->ntpServer = IPAddress(address);
+		network->ntpState = NTPState::RESOLVED;
+	} else {
+		network->ntpFailed();
+	}
+}
+
+void EthernetNetwork::ntpSend() {
+	uint8_t packetBuffer[NTP_PACKET_SIZE];
+
+	// Discard any late replies to previous queries
+	while (ntpSocket.parsePacket()) {
+		ntpSocket.flush();
 	}
 
-	return millis() + offset;
+	memset(packetBuffer, 0, NTP_PACKET_SIZE);
+
+	// Initialize values needed to form NTP request
+	// https://en.wikipedia.org/wiki/Network_Time_Protocol
+	packetBuffer[0] = 0b11100011;         // LI, Version, Mode
+	packetBuffer[1] = 0;                  // Stratum, or type of clock
+	packetBuffer[2] = NTP_VALID_INTERVAL; // Polling Interval
+	packetBuffer[3] = 0xEC;               // Peer Clock Precision
+	// 8 bytes of zero for Root Delay & Root Dispersion
+	packetBuffer[12] = 49;
+	packetBuffer[13] = 0x4E;
+	packetBuffer[14] = 49;
+	packetBuffer[15] = 52;
+
+	ntpSocket.beginPacket(ntpServer, NTP_PORT);
+	ntpSocket.write(packetBuffer, NTP_PACKET_SIZE);
+	ntpSocket.endPacket();
+
+	ntpLastQuery = millis();
+	ntpState = NTPState::WAITING;
 }
 
+void EthernetNetwork::ntpFailed() {
+	ntpState = NTPState::IDLE;
+	if (!ntpValid && ntpRetry < NTP_START_INTERVAL) {
+		ntpRetry++;
+	}
+}
+#endif
+
 #endif
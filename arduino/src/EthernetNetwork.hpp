@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017  Simon Arlott
+ * Copyright 2017,2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -25,19 +25,30 @@
 #ifdef ARDUINO_ARCH_ESP8266
 # pragma GCC diagnostic push
 # pragma GCC diagnostic ignored "-Wunused-parameter"
-# include <ESP8266WebServer.h>
+# include <ESPAsyncWebServer.h>
 # pragma GCC diagnostic pop
+# include <lwip/ip_addr.h>
 #endif
 
 #ifdef POWER_METER_HAS_NETWORK
 #include <WiFiUdp.h>
 
-class EthernetNetwork: public Print {
+/**
+Network services, run from the main loop in the time between meter reads.
+
+Nothing here waits for the network: the web server is asynchronous (its
+handlers run from the TCP stack and only update state or queue work),
+WiFi scans and NTP (including the DNS lookup) are polled for completion,
+and work that takes longer (committing settings to flash or resetting the
+meter) is deferred until there's at least SLOW_TASK_MILLIS until the next
+read.
+*/
+class EthernetNetwork final: public Print {
 public:
 	EthernetNetwork();
 	virtual ~EthernetNetwork();
 	virtual size_t write(uint8_t c);
-	void loop();
+	void loop(unsigned long slack);
 	void setConfigurationMode(bool configure);
 	operator bool() const;
 	bool isTimeValid();
@@ -51,6 +62,11 @@ protected:
 	};
 
 	void configureNetwork();
+	bool connectLastNetwork();
+	void scanNetworks();
+	bool connectKnownNetwork();
+	void checkConnection();
+	void runSlowTasks();
 	void sendPacket();
 
 	// Elementary charge is about 1.60217×10⁻¹⁹ coulombs
@@ -66,28 +82,73 @@ protected:
 	static constexpr size_t UDP_HLEN = 8;
 	static constexpr size_t MAX_LENGTH = ETH_DATA_LEN - IPV4_HLEN - UDP_HLEN;
 
+	/// Time to wait for a connection to the last network before scanning
+	static constexpr unsigned long FAST_CONNECT_TIMEOUT = 5000;
+	/// Time needed to run tasks that block (flash writes, meter reset)
+	static constexpr unsigned long SLOW_TASK_MILLIS = 250;
+
 	Mode mode = Mode::DISABLED;
 	char buffer[MAX_LENGTH];
 	size_t bufferLength = 0;
 
+	int network = -1; ///< Settings ID of the network being used
+	bool fastConnect = false; ///< Connecting using the last connection (without scanning)
+	bool connectionSaved = false;
+	bool scanning = false;
+	unsigned long connectStart = 0;
+	bool settingsChanged = false; ///< Commit settings when there's time
+
+	// Boot metrics (ms since startup, 0 if it hasn't happened yet)
+	unsigned long connectedMillis = 0;
+	unsigned long firstPacketMillis = 0;
+
 private:
 	static constexpr const char *NTP_DEFAULT_HOSTNAME = "pool.ntp.org";
 	static constexpr uint16_t NTP_PORT = 123;
+	static constexpr int NTP_PACKET_SIZE = 48; ///< NTP time stamp is in the first 48 bytes of the message
 	static constexpr unsigned long NTP_VALID_INTERVAL = 10;
 	static constexpr unsigned long NTP_START_INTERVAL = 6;
-	static constexpr unsigned long NTP_TIMEOUT = 2000;
+	/// Replies are only accepted within this time, so queries are only sent when
+	/// there's at least this long until the next read (which would delay the reply)
+	static constexpr unsigned long NTP_TIMEOUT = 300;
+	static constexpr unsigned long NTP_DNS_TIMEOUT = 5000;
+
+	enum class NTPState {
+		IDLE,
+		RESOLVING,
+		RESOLVED,
+		WAITING
+	};
+
+	void ntpLoop(unsigned long slack);
+	void ntpSend();
+	void ntpFailed();
+#ifdef ARDUINO_ARCH_ESP8266
+	static void ntpResolved(const char *name, const ip_addr_t *address, void *arg);
+#endif
 
 	const char *ntpHostname = "";
 	WiFiUDP ntpSocket;
 	bool ntpValid = false;
+	bool ntpStart = false;
+	NTPState ntpState = NTPState::IDLE;
+	IPAddress ntpServer;
+	unsigned long ntpLastQuery = 0;
+	unsigned long ntpOffset = 0;
+	unsigned long ntpRetry = 0; ///< Retry interval (log₂ seconds) until the time is valid
 
 #ifdef ARDUINO_ARCH_ESP8266
-	static void webServerRootPage();
-	static void webServerConfigPage();
-	static void webServerSavePage();
-	static void webServerResetPage();
-
-	ESP8266WebServer webServer{80};
+	static void webServerRootPage(AsyncWebServerRequest *request);
+	static void webServerConfigPage(AsyncWebServerRequest *request);
+	static void webServerSavePage(AsyncWebServerRequest *request);
+	static void webServerResetPage(AsyncWebServerRequest *request);
+	static const char *configPageField(char field, unsigned int index, char *scratch, size_t size);
+	void updateHeapUsage();
+
+	AsyncWebServer webServer{80};
+	AsyncWebServerRequest *resetRequest = nullptr; ///< Waiting for the meter to be reset
+	uint32_t resetPassword = 0;
+	uint32_t minFreeHeap = 0; ///< Lowest free heap seen (bytes)
 #endif
 };
 
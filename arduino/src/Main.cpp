@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017,2025  Simon Arlott
+ * Copyright 2017,2025-2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -16,47 +16,117 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <limits.h>
 #include <ModbusMaster.h>
+#ifdef POWER_METER_SECOND_BUS
+# include <SoftwareSerial.h>
+#endif
 
 #include "Main.hpp"
+#include "MemoryUsage.hpp"
+#include "OutputFormat.hpp"
 #include "Settings.hpp"
 #include "EthernetNetwork.hpp"
+#include "ModbusGateway.hpp"
 #include "RI_D19_80_C.hpp"
 #include "PZEM_004T_100A.hpp"
+#include "RS485.hpp"
+#include "StaticMeter.hpp"
+
+#ifdef POWER_METER_STATIC
+typedef StaticMeter<POWER_METER_CLASS> MeterClass;
+#else
+typedef POWER_METER_CLASS MeterClass;
+#endif
 
 ModbusMaster modbus;
-POWER_METER_CLASS meter{modbus, input, METER_ADDRESS};
+RS485 rs485{*input, DE_PIN, RE_PIN};
+MeterClass meter{modbus, &rs485, METER_ADDRESS};
+
+#ifdef POWER_METER_SECOND_BUS
+SoftwareSerial input2;
+ModbusMaster modbus2;
+RS485 rs485Bus2{input2, DE2_PIN, RE2_PIN};
+MeterClass meter2{modbus2, &rs485Bus2, METER2_ADDRESS};
+#endif
+
+static uint16_t sequence = 0;
+static unsigned long maxLateness = 0;
 
 static void enableTx() {
-	digitalWrite(RE_PIN, HIGH);
-	digitalWrite(DE_PIN, HIGH);
-	delay(INTER_FRAME_MILLIS);
+	rs485.beginTransmission();
 }
 
 static void disableTx() {
-	delay(INTER_FRAME_MILLIS);
-	digitalWrite(DE_PIN, LOW);
-	digitalWrite(RE_PIN, LOW);
+	rs485.endTransmission();
+}
+
+#ifdef POWER_METER_SECOND_BUS
+static void enableTxBus2() {
+	rs485Bus2.beginTransmission();
+}
+
+static void disableTxBus2() {
+	rs485Bus2.endTransmission();
+}
+
+static void pollBus2() {
+	rs485Bus2.poll();
 }
+#endif
 
 static void logTransmit(const uint8_t *data, size_t length) {
-	output->print("# TX");
+	output->print(F("# TX"));
 	for (size_t i = 0; i < length; i++) {
-		output->print(" ");
+		output->print(' ');
 		output->print(data[i], HEX);
 	}
 	output->println();
 }
 
 static void logReceive(const uint8_t *data, size_t length, uint8_t status) {
-	output->print("# RX");
+	output->print(F("# RX"));
 	for (size_t i = 0; i < length; i++) {
-		output->print(" ");
+		output->print(' ');
 		output->print(data[i], HEX);
 	}
-	output->print(" (");
+	output->print(F(" ("));
 	output->print(status, HEX);
-	output->println(")");
+	output->println(')');
+}
+
+static void logFirstReading() {
+	static bool logged = false;
+
+	if (!logged) {
+		output->print(F("# First reading after "));
+		output->print(millis());
+		output->println(F(" ms"));
+		logged = true;
+	}
+}
+
+static void logStackUsage() {
+	static size_t lowest = (size_t)-1;
+	size_t unused = MemoryUsage::unusedStack();
+
+	if (unused < lowest) {
+		output->print(F("# Unused stack: "));
+		output->print(unused);
+		output->println(F(" bytes"));
+		lowest = unused;
+	}
+}
+
+static void logOutputTime(unsigned long elapsed) {
+	static unsigned long highest = 0;
+
+	if (elapsed > highest) {
+		output->print(F("# Output time: "));
+		output->print(elapsed);
+		output->println(F(" us"));
+		highest = elapsed;
+	}
 }
 
 static void indicateStatus(bool success) {
@@ -66,6 +136,8 @@ static void indicateStatus(bool success) {
 }
 
 void setup() {
+	MemoryUsage::paintStack();
+
 	if (LED_PIN >= 0) {
 		pinMode(LED_PIN, OUTPUT);
 	}
@@ -74,11 +146,6 @@ void setup() {
 		pinMode(CONFIGURE_PIN, INPUT_PULLUP);
 	}
 
-	pinMode(DE_PIN, OUTPUT);
-	digitalWrite(DE_PIN, LOW);
-	pinMode(RE_PIN, OUTPUT);
-	digitalWrite(RE_PIN, LOW);
-
 	modbus.preTransmission(enableTx);
 	modbus.postTransmission(disableTx);
 	if (LOG_MESSAGES) {
@@ -86,7 +153,29 @@ void setup() {
 		modbus.logReceive(logReceive);
 	}
 
+#ifdef POWER_METER_SECOND_BUS
+	meter.setBus(1, METER_ADDRESS);
+	meter2.setBus(2, METER2_ADDRESS);
+	meter2.setFrameTiming(rs485Bus2);
+	modbus.idle(pollBus2);
+	modbus2.preTransmission(enableTxBus2);
+	modbus2.postTransmission(disableTxBus2);
+	if (LOG_MESSAGES) {
+		modbus2.logTransmit(logTransmit);
+		modbus2.logReceive(logReceive);
+	}
+
+	rs485Bus2.begin(INPUT_BAUD_RATE);
+	input2.begin(INPUT_BAUD_RATE, SWSERIAL_8N1, RX2_PIN, TX2_PIN, false, RS485::MAX_FRAME);
+#endif
+
+	meter.setFrameTiming(rs485);
+	rs485.begin(INPUT_BAUD_RATE);
+#ifdef __AVR__
+	input->begin(INPUT_BAUD_RATE, rs485);
+#else
 	input->begin(INPUT_BAUD_RATE);
+#endif
 	output->begin(OUTPUT_BAUD_RATE);
 
 #ifdef ARDUINO_ESP8266_ESP12
@@ -95,11 +184,107 @@ void setup() {
 
 #ifdef POWER_METER_HAS_NETWORK
 	Settings::init();
+
+# ifdef POWER_METER_SECOND_BUS
+	modbusGateway.add(1, meter);
+	modbusGateway.add(2, meter2);
+# else
+	modbusGateway.add(METER_ADDRESS, meter);
+# endif
+	modbusGateway.begin();
+#endif
+}
+
+static void outputReading(const MeterClass &reading) {
+	unsigned long outputStart = micros();
+
+	if (OutputFormat::write(reading, *output, sequence)) {
+		sequence++;
+	}
+	logOutputTime(micros() - outputStart);
+
+#ifdef POWER_METER_HAS_NETWORK
+	if (ethernetNetwork) {
+		TextFormat::write(reading, ethernetNetwork, sequence);
+	}
 #endif
 }
 
+/**
+ * Read the meters and output the readings, returning the time of the next
+ * read. Reads are only retried early if every meter failed.
+ *
+ * The second meter's request is transmitted before the first meter is
+ * read so that both meters respond at the same time, and its response is
+ * received in the background (see RS485::prefetch()). It's only read after
+ * the first meter's transaction has finished, so a slow or missing meter on
+ * one bus can't use up the response timeout of the other.
+ */
+static unsigned long readMeter(unsigned long start) {
+	bool success;
+
+#ifdef POWER_METER_SECOND_BUS
+	bool success2;
+
+	rs485Bus2.setResponseTimeout(meter2.health().responseTimeout());
+	if (meter2.health().due(millis())) {
+		rs485Bus2.prefetch();
+	}
+
+	rs485.setResponseTimeout(meter.health().responseTimeout());
+	success = meter.read();
+	success2 = meter2.read();
+
+	if (!success && !success2) {
+		indicateStatus(false);
+		return start + RETRY_MILLIS;
+	}
+
+	logFirstReading();
+	logStackUsage();
+
+	if (success) {
+		outputReading(meter);
+	}
+	if (success2) {
+		outputReading(meter2);
+	}
+#else
+	rs485.setResponseTimeout(meter.health().responseTimeout());
+	success = meter.read();
+
+	if (!success) {
+		indicateStatus(false);
+		return start + RETRY_MILLIS;
+	}
+
+	logFirstReading();
+	logStackUsage();
+
+	outputReading(meter);
+#endif
+	indicateStatus(true);
+
+#ifdef POWER_METER_HAS_NETWORK
+	if (ethernetNetwork.isTimeValid()) {
+		return millis() + 1000 - (ethernetNetwork.ntpMillis() % 1000);
+	}
+#endif
+
+	return start + READ_INTERVAL_MILLIS;
+}
+
+/**
+ * Cooperative scheduler: the meter is read when it's due and everything
+ * else runs in the time until the next read. Network tasks are given the
+ * remaining time so that they can avoid starting anything that could
+ * delay the read.
+ */
 void loop() {
-	unsigned long start = millis();
+	static bool started = false;
+	static unsigned long nextRead;
+	unsigned long now = millis();
+	long slack;
 
 	if (CONFIGURE_PIN >= 0) {
 #ifdef POWER_METER_HAS_NETWORK
@@ -109,48 +294,51 @@ void loop() {
 
 		if (configure) {
 			indicateStatus(false);
-			ethernetNetwork.loop();
+			ethernetNetwork.loop(ULONG_MAX);
 			return;
 		}
 #endif
 	}
 
-	if (*output) {
-		if (meter.read()) {
-			output->println(meter);
-			indicateStatus(true);
-#ifdef POWER_METER_HAS_NETWORK
-			if (ethernetNetwork) {
-				ethernetNetwork.println(meter);
-			}
-
-			ethernetNetwork.loop();
+	if (!*output) {
+		indicateStatus(false);
 
-			if (ethernetNetwork.isTimeValid()) {
-				delay(1000 - (ethernetNetwork.ntpMillis() % 1000));
-			} else {
-#endif
-				constexpr unsigned long wait = 500;
-				unsigned long duration = millis() - start;
-				if (duration < wait) {
-					delay(wait - duration);
-				}
 #ifdef POWER_METER_HAS_NETWORK
-			}
+		ethernetNetwork.loop(ULONG_MAX);
 #endif
-		} else {
-			indicateStatus(false);
-			delay(100);
+		return;
+	}
+
+	slack = started ? (long)(nextRead - now) : 0;
+	if (slack <= 0) {
+		if ((unsigned long)-slack > maxLateness) {
+			maxLateness = -slack;
 		}
-	} else {
-		indicateStatus(false);
+
+		nextRead = readMeter(now);
+		started = true;
+		return;
+	}
 
 #ifdef POWER_METER_HAS_NETWORK
-		ethernetNetwork.loop();
+	if (slack >= (long)TASK_SLACK_MILLIS) {
+		ethernetNetwork.loop(slack - TASK_SLACK_MILLIS);
+		slack = (long)(nextRead - millis());
+	}
 #endif
+
+	// Allow the network stack to run, without sleeping past the next read
+	if (slack > 1) {
+		delay(1);
+	} else {
+		yield();
 	}
 }
 
+unsigned long maxReadLateness() {
+	return maxLateness;
+}
+
 bool resetMeter(uint32_t password) {
 	meter.setPassword(password);
 	return meter.resetEnergy();
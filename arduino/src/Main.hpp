@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017,2025  Simon Arlott
+ * Copyright 2017,2025-2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -22,6 +22,8 @@
 #include <stdint.h>
 #include <Arduino.h>
 
+#include "AVRSerial1.hpp"
+
 #ifdef ARDUINO_ARCH_ESP8266
 # define POWER_METER_HAS_NETWORK
 #endif
@@ -48,36 +50,56 @@ constexpr auto *output = &Serial1;
 constexpr unsigned long OUTPUT_BAUD_RATE = 115200;
 #endif
 
+#ifdef POWER_METER_HOST
+constexpr int LED_PIN = -1;
+constexpr int CONFIGURE_PIN = -1;
+constexpr auto *output = &Serial; ///< stderr
+constexpr unsigned long OUTPUT_BAUD_RATE = 0;
+#endif
+
 // RS485
 #ifdef ARDUINO_AVR_MICRO
 constexpr int DE_PIN = 4;
 constexpr int RE_PIN = 5;
-constexpr auto *input = &Serial1;
+constexpr auto *input = &avrSerial1;
 #endif
 
 #ifdef ARDUINO_ESP8266_ESP12
 constexpr int DE_PIN = 4;
 constexpr int RE_PIN = 5;
 constexpr auto *input = &Serial;
+constexpr int RX2_PIN = 12;
+constexpr int TX2_PIN = 13;
+constexpr int DE2_PIN = 15;
+constexpr int RE2_PIN = 16;
 #endif
 
 #ifdef ARDUINO_ESP8266_WEMOS_D1R1
 constexpr int DE_PIN = 4;
 constexpr int RE_PIN = 5;
 constexpr auto *input = &Serial;
+constexpr int RX2_PIN = 12;
+constexpr int TX2_PIN = 13;
+constexpr int DE2_PIN = 15;
+constexpr int RE2_PIN = 16;
+#endif
+
+#if defined(POWER_METER_SECOND_BUS) && !defined(ARDUINO_ARCH_ESP8266)
+# error "A second RS485 bus is only supported on the ESP8266"
 #endif
 
 // Modbus
 constexpr unsigned long INPUT_BAUD_RATE = 9600;
 constexpr uint8_t METER_ADDRESS = 0x01;
+constexpr uint8_t METER2_ADDRESS = 0x01; ///< On the second bus
 constexpr bool LOG_MESSAGES = false;
 
-constexpr float INTER_FRAME_CHARS = 3.5;
-constexpr unsigned int CHAR_BITS = 10; // 8N1
-constexpr unsigned int INTER_FRAME_BITS = INTER_FRAME_CHARS * CHAR_BITS;
-constexpr unsigned int MS_PER_S = 1000;
-constexpr unsigned long INTER_FRAME_MILLIS = (INTER_FRAME_BITS * MS_PER_S / INPUT_BAUD_RATE) + 1;
+// Scheduler
+constexpr unsigned long READ_INTERVAL_MILLIS = 500; ///< When the time isn't valid
+constexpr unsigned long RETRY_MILLIS = 100;
+constexpr unsigned long TASK_SLACK_MILLIS = 2; ///< Time to leave for the network stack
 
 bool resetMeter(uint32_t password);
+unsigned long maxReadLateness();
 
 #endif
@@ -0,0 +1,57 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MemoryUsage.hpp"
+
+#ifdef __AVR__
+extern uint8_t __heap_start;
+extern void *__brkval;
+
+static uint8_t *heapEnd() {
+	return __brkval ? static_cast<uint8_t *>(__brkval) : &__heap_start;
+}
+#endif
+
+void MemoryUsage::paintStack() {
+#ifdef __AVR__
+	uint8_t marker;
+	uint8_t *end = &marker - MARGIN;
+
+	for (uint8_t *p = heapEnd(); p < end; p++) {
+		*p = CANARY;
+	}
+#endif
+}
+
+size_t MemoryUsage::unusedStack() {
+#if defined(__AVR__)
+	uint8_t marker;
+	uint8_t *p = heapEnd();
+	size_t unused = 0;
+
+	while (p < &marker && *p == CANARY) {
+		p++;
+		unused++;
+	}
+	return unused;
+#elif defined(ARDUINO_ARCH_ESP8266)
+	return ESP.getFreeContStack();
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,45 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_MEMORYUSAGE_HPP
+#define POWER_METER_MEMORYUSAGE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+/**
+Stack usage measurement.
+
+On AVR the free memory between the heap and the stack is filled with a
+known value at startup, and the amount of it that hasn't been overwritten
+is the stack high-water mark. The ESP8266 core measures its own stack.
+*/
+class MemoryUsage {
+public:
+	MemoryUsage() = delete;
+	virtual ~MemoryUsage() = delete;
+	static void paintStack();
+	static size_t unusedStack();
+
+private:
+	static constexpr uint8_t CANARY = 0xC5;
+	static constexpr size_t MARGIN = 32; ///< Bytes below the stack pointer to leave unpainted
+};
+
+#endif
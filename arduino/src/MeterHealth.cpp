@@ -0,0 +1,93 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MeterHealth.hpp"
+
+MeterHealth::MeterHealth()
+	: sampled_(false), smoothedLatency_(0), latencyDeviation_(0),
+		failures_(0), retryTime_(0) {
+
+}
+
+bool MeterHealth::due(unsigned long now) const {
+	if (failures_ < FAILURE_THRESHOLD) {
+		return true;
+	}
+
+	return (long)(now - retryTime_) >= 0;
+}
+
+bool MeterHealth::backedOff() const {
+	return failures_ >= FAILURE_THRESHOLD;
+}
+
+void MeterHealth::success(unsigned long latency) {
+	if (latency > MAX_TIMEOUT) {
+		latency = MAX_TIMEOUT;
+	}
+
+	if (!sampled_) {
+		smoothedLatency_ = latency << 3;
+		latencyDeviation_ = latency << 1;
+		sampled_ = true;
+	} else {
+		// Jacobson/Karels: gain of 1/8 for the mean and 1/4 for the deviation
+		long error = (long)latency - (long)(smoothedLatency_ >> 3);
+
+		smoothedLatency_ += error;
+		if (error < 0) {
+			error = -error;
+		}
+		error -= (latencyDeviation_ >> 2);
+		latencyDeviation_ += error;
+	}
+
+	failures_ = 0;
+}
+
+void MeterHealth::failure(unsigned long now) {
+	if (failures_ < UINT8_MAX) {
+		failures_++;
+	}
+
+	if (failures_ >= FAILURE_THRESHOLD) {
+		uint8_t shift = failures_ - FAILURE_THRESHOLD;
+		unsigned long backoff = MAX_BACKOFF_MILLIS;
+
+		if (shift < 8 && (BACKOFF_MILLIS << shift) < MAX_BACKOFF_MILLIS) {
+			backoff = BACKOFF_MILLIS << shift;
+		}
+
+		retryTime_ = now + backoff;
+	}
+}
+
+unsigned long MeterHealth::responseTimeout() const {
+	if (!sampled_) {
+		return MAX_TIMEOUT;
+	}
+
+	unsigned long timeout = (smoothedLatency_ >> 3) + latencyDeviation_;
+
+	if (timeout < MIN_TIMEOUT) {
+		return MIN_TIMEOUT;
+	} else if (timeout > MAX_TIMEOUT) {
+		return MAX_TIMEOUT;
+	}
+	return timeout;
+}
@@ -0,0 +1,59 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_METERHEALTH_HPP
+#define POWER_METER_METERHEALTH_HPP
+
+#include <stdint.h>
+
+/**
+Per-meter response latency and failure tracking.
+
+The response timeout is derived from the smoothed latency and its mean
+deviation (mean + 4·deviation, as for a TCP retransmission timeout) with
+a floor of MIN_TIMEOUT milliseconds. It's applied to each transaction by
+RS485::setResponseTimeout().
+
+After FAILURE_THRESHOLD consecutive failures the meter is only probed
+every BACKOFF_MILLIS × 2ⁿ milliseconds, up to MAX_BACKOFF_MILLIS, so
+that a missing meter does not hold up the bus.
+*/
+class MeterHealth {
+public:
+	MeterHealth();
+	bool due(unsigned long now) const;
+	bool backedOff() const; ///< Only being probed occasionally
+	void success(unsigned long latency);
+	void failure(unsigned long now);
+	unsigned long responseTimeout() const;
+
+	static constexpr unsigned long MIN_TIMEOUT = 50; ///< ms
+	static constexpr unsigned long MAX_TIMEOUT = 2000; ///< ms
+	static constexpr uint8_t FAILURE_THRESHOLD = 3;
+	static constexpr unsigned long BACKOFF_MILLIS = 100;
+	static constexpr unsigned long MAX_BACKOFF_MILLIS = 12800;
+
+private:
+	bool sampled_;
+	uint32_t smoothedLatency_; ///< ms × 8
+	uint32_t latencyDeviation_; ///< ms × 4
+	uint8_t failures_;
+	unsigned long retryTime_;
+};
+
+#endif
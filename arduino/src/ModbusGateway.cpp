@@ -0,0 +1,211 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ModbusGateway.hpp"
+
+#ifdef ARDUINO_ARCH_ESP8266
+#include <string.h>
+#include <algorithm>
+
+ModbusGateway modbusGateway;
+
+ModbusGateway::ModbusGateway() {
+
+}
+
+ModbusGateway::~ModbusGateway() {
+
+}
+
+void ModbusGateway::add(uint8_t unit, const PowerMeter &meter) {
+	if (meterCount_ < MAX_METERS) {
+		meters_[meterCount_++] = { unit, &meter };
+	}
+}
+
+void ModbusGateway::begin() {
+	server_.onClient(clientConnected, this);
+	server_.setNoDelay(true);
+	server_.begin();
+}
+
+void ModbusGateway::clientConnected(void *arg, AsyncClient *client) {
+	ModbusGateway *gateway = static_cast<ModbusGateway *>(arg);
+	Connection *connection = nullptr;
+
+	if (gateway->clients_ < MAX_CLIENTS) {
+		connection = new Connection{gateway, {}, 0};
+		gateway->clients_++;
+	}
+
+	client->onDisconnect(clientDisconnected, connection);
+	if (connection == nullptr) {
+		client->close(true);
+		return;
+	}
+
+	client->setNoDelay(true);
+	client->onData(clientData, connection);
+}
+
+void ModbusGateway::clientData(void *arg, AsyncClient *client, void *data, size_t length) {
+	Connection *connection = static_cast<Connection *>(arg);
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+	while (length > 0) {
+		size_t count = std::min(length, MAX_ADU_LENGTH - connection->length);
+
+		memcpy(&connection->buffer[connection->length], bytes, count);
+		connection->length += count;
+		bytes += count;
+		length -= count;
+
+		if (!connection->gateway->receive(*connection, *client)) {
+			client->close(true);
+			return;
+		}
+	}
+}
+
+void ModbusGateway::clientDisconnected(void *arg, AsyncClient *client) {
+	Connection *connection = static_cast<Connection *>(arg);
+
+	if (connection != nullptr) {
+		connection->gateway->clients_--;
+		delete connection;
+	}
+
+	delete client;
+}
+
+/**
+ * Respond to every complete request in the connection's buffer, returning
+ * false if the connection should be closed.
+ */
+bool ModbusGateway::receive(Connection &connection, AsyncClient &client) {
+	while (connection.length >= MBAP_LENGTH) {
+		const uint8_t *request = connection.buffer;
+		uint16_t protocol = (request[2] << 8) | request[3];
+		uint16_t length = (request[4] << 8) | request[5]; // Unit ID and PDU
+		size_t total = MBAP_LENGTH - 1 + length;
+		size_t responseLength;
+
+		if (protocol != 0 || length < 2 || total > MAX_ADU_LENGTH) {
+			return false;
+		}
+
+		if (connection.length < total) {
+			break;
+		}
+
+		responseLength = process(request, total, response_);
+		if (client.space() < responseLength
+				|| client.write(reinterpret_cast<const char *>(response_), responseLength) != responseLength) {
+			return false;
+		}
+
+		connection.length -= total;
+		memmove(connection.buffer, &connection.buffer[total], connection.length);
+	}
+
+	return true;
+}
+
+size_t ModbusGateway::process(const uint8_t *request, size_t length, uint8_t *response) {
+	uint8_t unit = request[6];
+	const uint8_t *pdu = &request[MBAP_LENGTH];
+	const PowerMeter *meter = find(unit);
+	size_t pduLength;
+
+	if (meter == nullptr) {
+		pduLength = exception(&response[MBAP_LENGTH], pdu[0], GATEWAY_PATH_UNAVAILABLE);
+	} else {
+		pduLength = readRegisters(*meter, pdu, length - MBAP_LENGTH, &response[MBAP_LENGTH]);
+	}
+
+	// Transaction ID, protocol ID and unit ID are the same as the request
+	memcpy(response, request, 4);
+	response[4] = (pduLength + 1) >> 8;
+	response[5] = (pduLength + 1) & 0xFF;
+	response[6] = unit;
+	return MBAP_LENGTH + pduLength;
+}
+
+size_t ModbusGateway::readRegisters(const PowerMeter &meter, const uint8_t *pdu, size_t length, uint8_t *response) {
+	const RegisterCache &registers = meter.registers();
+	uint8_t function = pdu[0];
+	uint16_t start;
+	uint16_t count;
+
+	if (function != RegisterCache::READ_HOLDING_REGISTERS
+			&& function != RegisterCache::READ_INPUT_REGISTERS) {
+		return exception(response, function, ILLEGAL_FUNCTION);
+	}
+
+	if (registers.function() == 0) {
+		// Nothing has been read from the meter yet
+		return exception(response, function, GATEWAY_TARGET_FAILED);
+	}
+
+	if (meter.health().backedOff() || millis() - registers.updated() > MAX_AGE_MILLIS) {
+		// The meter isn't responding so the values are out of date
+		return exception(response, function, GATEWAY_TARGET_FAILED);
+	}
+
+	if (function != registers.function()) {
+		return exception(response, function, ILLEGAL_FUNCTION);
+	}
+
+	if (length != 5) {
+		return exception(response, function, ILLEGAL_DATA_VALUE);
+	}
+
+	start = (pdu[1] << 8) | pdu[2];
+	count = (pdu[3] << 8) | pdu[4];
+	if (count == 0 || count > MAX_READ_REGISTERS) {
+		return exception(response, function, ILLEGAL_DATA_VALUE);
+	}
+
+	if (!registers.read(function, start, count, &response[2])) {
+		return exception(response, function, ILLEGAL_DATA_ADDRESS);
+	}
+
+	response[0] = function;
+	response[1] = count * 2;
+	return 2 + count * 2;
+}
+
+size_t ModbusGateway::exception(uint8_t *response, uint8_t function, uint8_t code) {
+	response[0] = function | EXCEPTION;
+	response[1] = code;
+	return 2;
+}
+
+const PowerMeter *ModbusGateway::find(uint8_t unit) const {
+	if (unit == 0xFF && meterCount_ > 0) {
+		return meters_[0].meter;
+	}
+
+	for (size_t i = 0; i < meterCount_; i++) {
+		if (meters_[i].unit == unit) {
+			return meters_[i].meter;
+		}
+	}
+
+	return nullptr;
+}
+#endif
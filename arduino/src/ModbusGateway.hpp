@@ -0,0 +1,103 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef POWER_METER_MODBUSGATEWAY_HPP
+#define POWER_METER_MODBUSGATEWAY_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+#ifdef ARDUINO_ARCH_ESP8266
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wunused-parameter"
+# include <ESPAsyncTCP.h>
+# pragma GCC diagnostic pop
+
+#include "PowerMeter.hpp"
+
+/**
+Modbus TCP server that answers register reads from the meters' register
+caches (see RegisterCache.hpp), so that any number of clients can read
+them at any rate without using the RS485 bus.
+
+Requests are answered immediately from the TCP stack. The unit ID
+selects the meter (0xFF is the first meter). Responses have the
+register values from the meter's last successful read. Writes and any other
+functions are refused with an illegal function exception, and registers
+that haven't been read from the meter are an illegal data address.
+
+If the meter has stopped responding (it's backed off, or the last
+successful read is older than MAX_AGE_MILLIS) reads fail with a gateway
+target failed exception instead of returning old values.
+*/
+class ModbusGateway {
+public:
+	ModbusGateway();
+	~ModbusGateway();
+	void add(uint8_t unit, const PowerMeter &meter);
+	void begin();
+
+	static constexpr uint16_t PORT = 502;
+	static constexpr size_t MAX_CLIENTS = 4;
+	static constexpr size_t MAX_METERS = 2;
+	static constexpr unsigned long MAX_AGE_MILLIS = 5000; ///< Several read intervals
+
+private:
+	static constexpr size_t MBAP_LENGTH = 7; ///< Transaction ID, protocol ID, length, unit ID
+	static constexpr size_t MAX_PDU_LENGTH = 253;
+	static constexpr size_t MAX_ADU_LENGTH = MBAP_LENGTH + MAX_PDU_LENGTH;
+	static constexpr uint16_t MAX_READ_REGISTERS = 125;
+
+	static constexpr uint8_t EXCEPTION = 0x80;
+	static constexpr uint8_t ILLEGAL_FUNCTION = 0x01;
+	static constexpr uint8_t ILLEGAL_DATA_ADDRESS = 0x02;
+	static constexpr uint8_t ILLEGAL_DATA_VALUE = 0x03;
+	static constexpr uint8_t GATEWAY_PATH_UNAVAILABLE = 0x0A;
+	static constexpr uint8_t GATEWAY_TARGET_FAILED = 0x0B;
+
+	struct Connection {
+		ModbusGateway *gateway;
+		uint8_t buffer[MAX_ADU_LENGTH];
+		size_t length;
+	};
+
+	struct Meter {
+		uint8_t unit;
+		const PowerMeter *meter;
+	};
+
+	static void clientConnected(void *arg, AsyncClient *client);
+	static void clientData(void *arg, AsyncClient *client, void *data, size_t length);
+	static void clientDisconnected(void *arg, AsyncClient *client);
+	bool receive(Connection &connection, AsyncClient &client);
+	size_t process(const uint8_t *request, size_t length, uint8_t *response);
+	size_t readRegisters(const PowerMeter &meter, const uint8_t *pdu, size_t length, uint8_t *response);
+	static size_t exception(uint8_t *response, uint8_t function, uint8_t code);
+	const PowerMeter *find(uint8_t unit) const;
+
+	AsyncServer server_{PORT};
+	Meter meters_[MAX_METERS];
+	size_t meterCount_ = 0;
+	size_t clients_ = 0;
+	uint8_t response_[MAX_ADU_LENGTH]; ///< Shared by all clients (they're not processed concurrently)
+};
+
+extern ModbusGateway modbusGateway;
+#endif
+
+#endif
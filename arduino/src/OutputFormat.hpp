@@ -0,0 +1,64 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_OUTPUTFORMAT_HPP
+#define POWER_METER_OUTPUTFORMAT_HPP
+
+#include <stdint.h>
+#include <Arduino.h>
+
+/**
+Output formats for readings.
+
+The meter and the sink are template parameters so that they're called
+through their own types, and the format is selected at compile time so
+that only the one that's used is included.
+*/
+
+/// YAML text, one reading per line
+class TextFormat {
+public:
+	TextFormat() = delete;
+
+	template <class Meter, class Sink>
+	static bool write(const Meter &meter, Sink &sink, uint16_t sequence __attribute__((unused))) {
+		size_t n = meter.printTo(sink);
+
+		n += sink.println();
+		return n > 0;
+	}
+};
+
+/// COBS encoded binary frames (see BinaryFrame.hpp)
+class BinaryFormat {
+public:
+	BinaryFormat() = delete;
+
+	template <class Meter, class Sink>
+	static bool write(const Meter &meter, Sink &sink, uint16_t sequence) {
+		return meter.writeFrameTo(sink, sequence) > 0;
+	}
+};
+
+#ifdef POWER_METER_BINARY_OUTPUT
+typedef BinaryFormat OutputFormat;
+#else
+typedef TextFormat OutputFormat;
+#endif
+
+#endif
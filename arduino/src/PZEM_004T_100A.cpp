@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2025  Simon Arlott
+ * Copyright 2025-2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -27,8 +27,8 @@ PZEM_004T_100A::~PZEM_004T_100A() {
 
 }
 
-String PZEM_004T_100A::model() const {
-	return "PZEM-004T-100A";
+const __FlashStringHelper *PZEM_004T_100A::model() const {
+	return F("PZEM-004T-100A");
 }
 
 bool PZEM_004T_100A::readSerialNumber() {
@@ -39,13 +39,15 @@ bool PZEM_004T_100A::readSerialNumber() {
 };
 
 bool PZEM_004T_100A::readMeasurements() {
+	unsigned long start;
 	uint8_t ret;
 
 	modbus.begin(address, *io);
 
-	ret = modbus.readInputRegisters(0x0000, 9);
-	if (ret != ModbusMaster::ku8MBSuccess) {
-		success = 1;
+	start = millis();
+	ret = modbus.readInputRegisters(0x0000, MEASUREMENT_REGISTERS);
+	if (!responseReceived(start, ret == ModbusMaster::ku8MBSuccess)) {
+		warmup = 0;
 		return false;
 	}
 
@@ -62,30 +64,48 @@ bool PZEM_004T_100A::readMeasurements() {
 	frequency = Decimal(modbus.getResponseBuffer(0x0007), -1);
 	powerFactor = Decimal(modbus.getResponseBuffer(0x0008), -2);
 
-	/* Ignore the first 20 readings (about 2-3 seconds) to avoid invalid readings on startup */
-	if (success < 20) {
-		success++;
+	/*
+	 * Invalid readings are reported across all values on startup for a few seconds:
+	 * {model: "PZEM-004T-100A",reading: {voltage: 3477.0e-1,current: 1229079690.0e-3,frequency: 42216.0e-1,activePower: 219717939.0e-1,powerFactor: 54580.0e-2,activeEnergy: 3797280931.0}}
+	 *
+	 * Wait until several consecutive readings are plausible and the energy
+	 * counter is consistent between them, instead of a fixed number of readings.
+	 */
+	if (!plausible()) {
+		warmup = 0;
 		return false;
 	}
 
+	if (warmup < WARMUP_READINGS) {
+		uint32_t energy = activeEnergy.coefficient();
+
+		if (warmup > 0 && (energy < lastEnergy || energy - lastEnergy > WARMUP_MAX_ENERGY)) {
+			warmup = 0;
+		}
+
+		lastEnergy = energy;
+		warmup++;
+		if (warmup < WARMUP_READINGS) {
+			return false;
+		}
+	}
+
+	registers_.store(RegisterCache::READ_INPUT_REGISTERS, 0x0000, MEASUREMENT_REGISTERS, modbus);
+	return true;
+}
+
+bool PZEM_004T_100A::plausible() const {
 	/*
-	 * Invalid readings are reported across all values on startup for a few seconds:
-	 * {model: "PZEM-004T-100A",reading: {voltage: 3477.0e-1,current: 1229079690.0e-3,frequency: 42216.0e-1,activePower: 219717939.0e-1,powerFactor: 54580.0e-2,activeEnergy: 3797280931.0}}
-	 * 
 	 * Incorrect readings are reported on shutdown when the voltage goes away:
 	 * meter: {model: "PZEM-004T-100A",reading: {voltage: 2468.0e-1,current: 1788.0e-3,frequency: 499.0e-1,activePower: 2485.0e-1,powerFactor: 56.0e-2,activeEnergy: 2875.0}}
 	 * meter: {model: "PZEM-004T-100A",reading: {voltage: 47.0e-1,current: 1761.0e-3,frequency: 500.0e-1,activePower: 103.0e-1,powerFactor: 100.0e-2,activeEnergy: 2875.0}}
 	 */
-	if (voltage.coefficient() < 800 /* 80.0V */
-			|| voltage.coefficient() > 3000 /* 300.0V */
-			|| frequency.coefficient() < 250 /* 25.0Hz */
-			|| frequency.coefficient() > 750 /* 75.0Hz */
-			|| activePower.coefficient() > 500000 /* 50,000.0W */
-			|| powerFactor.coefficient() > 10000 /* 100.00% */) {
-		return false;
-	}
-
-  	return true;
+	return voltage.coefficient() >= 800 /* 80.0V */
+		&& voltage.coefficient() <= 3000 /* 300.0V */
+		&& frequency.coefficient() >= 250 /* 25.0Hz */
+		&& frequency.coefficient() <= 750 /* 75.0Hz */
+		&& activePower.coefficient() <= 500000 /* 50,000.0W */
+		&& powerFactor.coefficient() <= 10000 /* 100.00% */;
 }
 
 bool PZEM_004T_100A::resetEnergy() {
@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2025  Simon Arlott
+ * Copyright 2025-2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -47,12 +47,20 @@ public:
 protected:
     bool readSerialNumber() override;
     bool readMeasurements() override;
-	String model() const override;
+	const __FlashStringHelper *model() const override;
+	bool plausible() const;
+
+	static constexpr uint8_t MEASUREMENT_REGISTERS = 9;
+	/// Consecutive plausible readings required after startup
+	static constexpr uint8_t WARMUP_READINGS = 3;
+	/// Maximum energy increase between readings while warming up (W·h)
+	static constexpr uint32_t WARMUP_MAX_ENERGY = 100;
 
 	ModbusMaster &modbus;
 	Stream *io;
 	uint8_t address;
-    uint8_t success{1};
+	uint8_t warmup{0}; ///< Consecutive plausible readings
+	uint32_t lastEnergy{0}; ///< W·h
 };
 
 #endif
@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017,2025  Simon Arlott
+ * Copyright 2017,2025-2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -18,6 +18,25 @@
 
 #include "PowerMeter.hpp"
 
+static const char NAME_VOLTAGE[] PROGMEM = "voltage";
+static const char NAME_CURRENT[] PROGMEM = "current";
+static const char NAME_FREQUENCY[] PROGMEM = "frequency";
+static const char NAME_ACTIVE_POWER[] PROGMEM = "activePower";
+static const char NAME_REACTIVE_POWER[] PROGMEM = "reactivePower";
+static const char NAME_APPARENT_POWER[] PROGMEM = "apparentPower";
+static const char NAME_POWER_FACTOR[] PROGMEM = "powerFactor";
+static const char NAME_TEMPERATURE[] PROGMEM = "temperature";
+static const char NAME_ACTIVE_ENERGY[] PROGMEM = "activeEnergy";
+static const char NAME_REACTIVE_ENERGY[] PROGMEM = "reactiveEnergy";
+
+/// Value names, in the same order as value() and the binary frame bitmap
+static const char *const NAMES[PowerMeter::VALUES] PROGMEM = {
+	NAME_VOLTAGE, NAME_CURRENT, NAME_FREQUENCY,
+	NAME_ACTIVE_POWER, NAME_REACTIVE_POWER, NAME_APPARENT_POWER, NAME_POWER_FACTOR,
+	NAME_TEMPERATURE,
+	NAME_ACTIVE_ENERGY, NAME_REACTIVE_ENERGY,
+};
+
 PowerMeter::PowerMeter() {
 
 }
@@ -27,15 +46,68 @@ PowerMeter::~PowerMeter() {
 }
 
 bool PowerMeter::read() {
-	if (serialNumber.length() == 0) {
-		if (!readSerialNumber()) {
-			return false;
-		}
+	return readWith([this] { return readSerialNumber(); }, [this] { return readMeasurements(); });
+}
+
+void PowerMeter::setBus(uint8_t bus, uint8_t address) {
+	bus_ = bus;
+	address_ = address;
+}
+
+const MeterHealth &PowerMeter::health() const {
+	return health_;
+}
+
+const RegisterCache &PowerMeter::registers() const {
+	return registers_;
+}
+
+#ifndef POWER_METER_HOST
+/**
+ * Measure response latency from the end of the request to the last byte
+ * of the response on this bus.
+ */
+void PowerMeter::setFrameTiming(const RS485 &rs485) {
+	rs485_ = &rs485;
+}
+#endif
+
+bool PowerMeter::responseReceived(unsigned long start, bool success) {
+	if (success) {
+		health_.success(latency(start));
+	} else {
+		health_.failure(millis());
+	}
+
+	return success;
+}
+
+/**
+ * Time (ms, rounded up) that the meter took to respond to the last request.
+ */
+unsigned long PowerMeter::latency(unsigned long start) const {
+#ifndef POWER_METER_HOST
+	if (rs485_ != nullptr) {
+		return (rs485_->frameMicros() - rs485_->requestMicros() + 999) / 1000;
 	}
+#endif
 
-	clearMeasurements();
+	return millis() - start;
+}
 
-	return readMeasurements();
+const Decimal &PowerMeter::value(uint8_t index) const {
+	switch (index) {
+	case 0: return voltage;
+	case 1: return current;
+	case 2: return frequency;
+	case 3: return activePower;
+	case 4: return reactivePower;
+	case 5: return apparentPower;
+	case 6: return powerFactor;
+	case 7: return temperature;
+	case 8: return activeEnergy;
+	default: return reactiveEnergy;
+	}
 }
 
 void PowerMeter::clearMeasurements() {
@@ -54,51 +126,42 @@ void PowerMeter::clearMeasurements() {
 }
 
 size_t PowerMeter::printTo(Print &p) const {
+	return printTo(p, model());
+}
+
+size_t PowerMeter::printTo(Print &p, const __FlashStringHelper *model) const {
 	size_t n = 0;
 	bool first = true;
 
-	n += p.print("meter: {model: \"");
-	n += p.print(model());
-	n += p.print("\"");
+	n += p.print(F("meter: {model: \""));
+	n += p.print(model);
+	n += p.print('"');
 
 	if (serialNumber.length() > 0) {
-		n += p.print(",serialNumber: \"");
+		n += p.print(F(",serialNumber: \""));
 		n += p.print(serialNumber);
-		n += p.print("\"");
+		n += p.print('"');
+	}
+
+	if (bus_ > 0) {
+		n += p.print(F(",bus: "));
+		n += p.print(bus_);
+		n += p.print(F(",address: "));
+		n += p.print(address_);
+	}
+
+	n += p.print(F(",reading: {"));
+
+	for (uint8_t i = 0; i < VALUES; i++) {
+		n += printReading(p, first, reinterpret_cast<const __FlashStringHelper *>(pgm_read_ptr(&NAMES[i])), value(i));
 	}
 
-	n += p.print(",reading: {");
-
-	if (voltage.hasValue())
-		n += printReading(p, first, "voltage", voltage);
-	if (current.hasValue())
-		n += printReading(p, first, "current", current);
-	if (frequency.hasValue())
-		n += printReading(p, first, "frequency", frequency);
-		
-	if (activePower.hasValue())
-		n += printReading(p, first, "activePower", activePower);
-	if (reactivePower.hasValue())
-		n += printReading(p, first, "reactivePower", reactivePower);
-	if (apparentPower.hasValue())
-		n += printReading(p, first, "apparentPower", apparentPower);
-	if (powerFactor.hasValue())
-		n += printReading(p, first, "powerFactor", powerFactor);
-
-	if (temperature.hasValue())
-		n += printReading(p, first, "temperature", temperature);
-
-	if (activeEnergy.hasValue())
-		n += printReading(p, first, "activeEnergy", activeEnergy);
-	if (reactiveEnergy.hasValue())
-		n += printReading(p, first, "reactiveEnergy", reactiveEnergy);
-
-	n += p.print("}}");
+	n += p.print(F("}}"));
 
 	return n;
 }
 
-size_t PowerMeter::printReading(Print &p, bool &first, const char *name, const Decimal &value) {
+size_t PowerMeter::printReading(Print &p, bool &first, const __FlashStringHelper *name, const Decimal &value) {
 	size_t n = 0;
 
 	if (value.hasValue()) {
@@ -109,9 +172,48 @@ size_t PowerMeter::printReading(Print &p, bool &first, const char *name, const D
 		}
 
 		n += p.print(name);
-		n += p.print(": ");
+		n += p.print(F(": "));
 		n += p.print(value);
 	}
 
 	return n;
 }
+
+size_t PowerMeter::writeFrameTo(Print &p, uint16_t sequence) const {
+	return writeFrameTo(p, sequence, model());
+}
+
+size_t PowerMeter::writeFrameTo(Print &p, uint16_t sequence, const __FlashStringHelper *model) const {
+	BinaryFrame frame;
+	uint16_t present = 0;
+	uint16_t sign = 0;
+
+	for (uint8_t i = 0; i < VALUES; i++) {
+		if (value(i).hasValue()) {
+			present |= 1U << i;
+			if (value(i).coefficientSigned()) {
+				sign |= 1U << i;
+			}
+		}
+	}
+
+	frame.add(bus_ > 0 ? BinaryFrame::VERSION_BUS : BinaryFrame::VERSION);
+	frame.add(sequence);
+	frame.add(model);
+	frame.add(serialNumber);
+	if (bus_ > 0) {
+		frame.add(bus_);
+		frame.add(address_);
+	}
+	frame.add(present);
+	frame.add(sign);
+
+	for (uint8_t i = 0; i < VALUES; i++) {
+		if (value(i).hasValue()) {
+			frame.add((uint8_t)value(i).exponent());
+			frame.add(value(i).coefficient());
+		}
+	}
+
+	return frame.writeTo(p);
+}
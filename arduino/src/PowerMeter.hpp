@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017  Simon Arlott
+ * Copyright 2017,2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -21,22 +21,63 @@
 
 #include <Arduino.h>
 
+#include "BinaryFrame.hpp"
 #include "Decimal.hpp"
+#include "MeterHealth.hpp"
+#include "RegisterCache.hpp"
+#ifndef POWER_METER_HOST
+# include "RS485.hpp"
+#endif
 
 class PowerMeter: public Printable {
 public:
 	PowerMeter();
 	virtual ~PowerMeter();
 	bool read();
+	void setBus(uint8_t bus, uint8_t address);
+#ifndef POWER_METER_HOST
+	void setFrameTiming(const RS485 &rs485);
+#endif
+	const MeterHealth &health() const;
+	const RegisterCache &registers() const;
 	virtual size_t printTo(Print &p) const __attribute__((warn_unused_result));
+	size_t writeFrameTo(Print &p, uint16_t sequence) const __attribute__((warn_unused_result));
+
+	static constexpr uint8_t VALUES = 10;
 
 protected:
+	/**
+	 * Read the meter (if it's due) using the driver's functions, reading
+	 * the serial number first if it hasn't been read yet. This is shared
+	 * by read() and StaticMeter, which call the driver differently.
+	 */
+	template <class ReadSerialNumber, class ReadMeasurements>
+	bool readWith(ReadSerialNumber readSerialNumber, ReadMeasurements readMeasurements) {
+		if (!health_.due(millis())) {
+			return false;
+		}
+
+		if (serialNumber.length() == 0) {
+			if (!readSerialNumber()) {
+				return false;
+			}
+		}
+
+		clearMeasurements();
+
+		return readMeasurements();
+	}
+
+	size_t printTo(Print &p, const __FlashStringHelper *model) const __attribute__((warn_unused_result));
+	size_t writeFrameTo(Print &p, uint16_t sequence, const __FlashStringHelper *model) const __attribute__((warn_unused_result));
 	void clearMeasurements();
+	bool responseReceived(unsigned long start, bool success);
 	virtual bool readSerialNumber() = 0;
 	virtual bool readMeasurements() = 0;
-	virtual String model() const = 0;
+	virtual const __FlashStringHelper *model() const = 0;
 
 	String serialNumber;
+	RegisterCache registers_;
 
 	// Gauge values
 	Decimal voltage; ///< V
@@ -54,7 +95,17 @@ protected:
 	Decimal reactiveEnergy; ///< kW·h
 
 private:
-	static size_t printReading(Print &p, bool &first, const char *name, const Decimal &value) __attribute__((warn_unused_result));
+	MeterHealth health_;
+	uint8_t bus_ = 0; ///< Output with the reading if there's more than one bus
+	uint8_t address_ = 0;
+#ifndef POWER_METER_HOST
+	const RS485 *rs485_ = nullptr; ///< Response latency from frame times instead of millis()
+#endif
+
+	unsigned long latency(unsigned long start) const;
+	const Decimal &value(uint8_t index) const;
+
+	static size_t printReading(Print &p, bool &first, const __FlashStringHelper *name, const Decimal &value) __attribute__((warn_unused_result));
 };
 
 #endif
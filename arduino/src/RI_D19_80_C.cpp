@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017  Simon Arlott
+ * Copyright 2017,2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -27,8 +27,8 @@ RI_D19_80_C::~RI_D19_80_C() {
 
 }
 
-String RI_D19_80_C::model() const {
-	return "RI-D19-80-C";
+const __FlashStringHelper *RI_D19_80_C::model() const {
+	return F("RI-D19-80-C");
 }
 
 static char bcd2char(uint16_t value) {
@@ -51,15 +51,19 @@ static uint16_t dec2bcd(uint16_t value) {
 
 bool RI_D19_80_C::readSerialNumber() {
 	constexpr uint8_t len = 3;
+	unsigned long start;
 	uint8_t ret;
 
 	modbus.begin(address, *io);
 
+	start = millis();
 	ret = modbus.readHoldingRegisters(0x0027, len);
-	if (ret != ModbusMaster::ku8MBSuccess) {
+	if (!responseReceived(start, ret == ModbusMaster::ku8MBSuccess)) {
 		return false;
 	}
 
+	registers_.store(RegisterCache::READ_HOLDING_REGISTERS, 0x0027, len, modbus);
+
 	for (uint8_t i = 0; i < len; i++) {
 		uint16_t value = modbus.getResponseBuffer(i);
 
@@ -73,15 +77,19 @@ bool RI_D19_80_C::readSerialNumber() {
 }
 
 bool RI_D19_80_C::readMeasurements() {
+	unsigned long start;
 	uint8_t ret;
 
 	modbus.begin(address, *io);
 
+	start = millis();
 	ret = modbus.readHoldingRegisters(0x0000, debug ? 0x0027 : 0x0026);
-	if (ret != ModbusMaster::ku8MBSuccess) {
+	if (!responseReceived(start, ret == ModbusMaster::ku8MBSuccess)) {
 		return false;
 	}
 
+	registers_.store(RegisterCache::READ_HOLDING_REGISTERS, 0x0000, debug ? 0x0027 : 0x0026, modbus);
+
 	voltage = Decimal(modbus.getResponseBuffer(0x0000), -1);
 	current = Decimal(modbus.getResponseBuffer(0x0001), -1);
 	frequency = Decimal(modbus.getResponseBuffer(0x0002), -1);
@@ -103,12 +111,12 @@ bool RI_D19_80_C::readMeasurements() {
 		// Check if Active Energy (Total) doesn't match Active Energy (T1)
 		if (modbus.getResponseBuffer(0x0007) != modbus.getResponseBuffer(0x0009)
 				|| modbus.getResponseBuffer(0x0008) != modbus.getResponseBuffer(0x000A)) {
-			output->print(first ? "# " : "; ");
+			output->print(first ? F("# ") : F("; "));
 			first = false;
-			output->print("0x0007..0x000A = ");
+			output->print(F("0x0007..0x000A = "));
 			for (uint8_t i = 0x0007; i <= 0x000A; i++) {
 				if (i > 0x0007) {
-					output->print(" ");
+					output->print(' ');
 				}
 
 				output->print(modbus.getResponseBuffer(i), HEX);
@@ -125,12 +133,12 @@ bool RI_D19_80_C::readMeasurements() {
 		}
 
 		if (!all_zeros) {
-			output->print(first ? "# " : "; ");
+			output->print(first ? F("# ") : F("; "));
 			first = false;
-			output->print("0x000B..0x0020 = ");
+			output->print(F("0x000B..0x0020 = "));
 			for (uint8_t i = zero_start; i <= zero_end; i++) {
 				if (i > zero_start) {
-					output->print(" ");
+					output->print(' ');
 				}
 
 				output->print(modbus.getResponseBuffer(i), HEX);
@@ -141,21 +149,21 @@ bool RI_D19_80_C::readMeasurements() {
 		// (this is probably a software version)
 		uint8_t unknown = modbus.getResponseBuffer(0x0026);
 		if (unknown != 0xF6 && unknown != 0xFB) {
-			output->print(first ? "# " : "; ");
+			output->print(first ? F("# ") : F("; "));
 			first = false;
-			output->print("0x0026 = 0x");
+			output->print(F("0x0026 = 0x"));
 			output->print(modbus.getResponseBuffer(0x0026), HEX);
 		}
 
 		ret = modbus.readHoldingRegisters(0x002E, 2);
 		if (ret == ModbusMaster::ku8MBSuccess) {
-			output->print(first ? "# " : "; ");
+			output->print(first ? F("# ") : F("; "));
 			first = false;
-			output->print("0x002E..0x002F = ");
+			output->print(F("0x002E..0x002F = "));
 
 			for (uint8_t i = 0; i <= 1; i++) {
 				if (i > 0) {
-					output->print(" ");
+					output->print(' ');
 				}
 
 				output->print(modbus.getResponseBuffer(i), HEX);
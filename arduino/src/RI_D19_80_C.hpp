@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017,2025  Simon Arlott
+ * Copyright 2017,2025-2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -78,7 +78,7 @@ public:
 protected:
 	bool readSerialNumber() override;
 	bool readMeasurements() override;
-	String model() const override;
+	const __FlashStringHelper *model() const override;
 
 	static constexpr uint32_t maximumEnergy = 99999999; // daW·h (6+2 record, 5+1 display)
 	static constexpr bool debug = false;
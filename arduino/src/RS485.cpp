@@ -0,0 +1,365 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "RS485.hpp"
+
+#include <string.h>
+
+RS485::RS485(Stream &uart, int dePin, int rePin) : uart_(uart), dePin_(dePin), rePin_(rePin) {
+
+}
+
+RS485::~RS485() {
+
+}
+
+void RS485::begin(unsigned long baudRate) {
+	pinMode(dePin_, OUTPUT);
+	digitalWrite(dePin_, LOW);
+	pinMode(rePin_, OUTPUT);
+	digitalWrite(rePin_, LOW);
+
+	charMicros_ = (CHAR_BITS * 1000000UL + baudRate - 1) / baudRate;
+	if (baudRate > MAX_BAUD_RATE_TIMING) {
+		gapMicros_ = FIXED_INTER_FRAME_MICROS;
+	} else {
+		gapMicros_ = (INTER_FRAME_BITS * 1000000UL + baudRate - 1) / baudRate;
+	}
+	lastMicros_ = micros();
+}
+
+void RS485::beginTransmission() {
+	if (prefetch_ == Prefetch::SENT) {
+		// This could be the request that has already been transmitted
+		prefetch_ = Prefetch::MATCHING;
+		prefetchMatched_ = 0;
+		return;
+	}
+
+	startTransmission();
+}
+
+void RS485::startTransmission() {
+	unsigned long start = micros();
+
+	while (!quiet() && micros() - start < gapMicros_ + MAX_FRAME * charMicros_) {
+		yield();
+	}
+
+	noInterrupts();
+	length_ = 0;
+	complete_ = false;
+	position_ = 0;
+	interrupts();
+
+	requestLength_ = 0;
+	awaitingResponse_ = false;
+	prefetch_ = Prefetch::NONE;
+	transmitting_ = true;
+	digitalWrite(rePin_, HIGH);
+	digitalWrite(dePin_, HIGH);
+}
+
+void RS485::endTransmission() {
+	if (prefetch_ == Prefetch::MATCHING) {
+		if (prefetchMatched_ == sizeof(lastRequest_)) {
+			// Same request, so its response is already being received
+			prefetch_ = Prefetch::NONE;
+			return;
+		}
+
+		transmitPrefetched();
+	}
+
+	flush();
+	digitalWrite(dePin_, LOW);
+	digitalWrite(rePin_, LOW);
+	transmitting_ = false;
+
+	requestMicros_ = micros();
+	noInterrupts();
+	lastMicros_ = requestMicros_;
+	interrupts();
+
+	awaitingResponse_ = requestLength_ >= 2 && request_[0] != BROADCAST_ADDRESS;
+	requestMillis_ = millis();
+
+	lastRequestValid_ = requestLength_ == sizeof(request_) && request_[0] != BROADCAST_ADDRESS
+		&& (request_[1] == READ_HOLDING_REGISTERS || request_[1] == READ_INPUT_REGISTERS);
+	if (lastRequestValid_) {
+		memcpy(lastRequest_, request_, sizeof(lastRequest_));
+	}
+}
+
+/**
+ * Transmit the last read request again now, returning false if there
+ * isn't one. Its response is only available once the same request is
+ * written again.
+ */
+bool RS485::prefetch() {
+	if (!lastRequestValid_) {
+		return false;
+	}
+
+	startTransmission();
+	write(lastRequest_, sizeof(lastRequest_));
+	endTransmission();
+
+	prefetch_ = Prefetch::SENT;
+	return true;
+}
+
+/**
+ * The request being written is different from the prefetched request, so
+ * transmit it normally (after the prefetched response) starting with the
+ * bytes that matched.
+ */
+void RS485::transmitPrefetched() {
+	uint8_t matched = prefetchMatched_;
+
+	// Wait for the prefetched response to start (or time out) so that the
+	// meter isn't still processing the prefetched request
+	while (awaitingResponse_ && responseTimeout_ != 0) {
+		frameComplete();
+		yield();
+	}
+
+	startTransmission();
+	write(lastRequest_, matched);
+}
+
+/**
+ * Time (ms) to wait for the start of a response after each request, or 0
+ * to wait indefinitely.
+ */
+void RS485::setResponseTimeout(unsigned long timeout) {
+	responseTimeout_ = timeout;
+}
+
+/**
+ * Time (µs) that the last request finished transmitting.
+ */
+unsigned long RS485::requestMicros() const {
+	return requestMicros_;
+}
+
+/**
+ * Time (µs) that the last byte of the most recent frame was received.
+ */
+unsigned long RS485::frameMicros() const {
+	return frameMicros_;
+}
+
+void RS485::receive(uint8_t data, unsigned long now, bool error) {
+	append(data, now, now - lastMicros_ >= gapMicros_, error);
+}
+
+void RS485::append(uint8_t data, unsigned long now, bool start, bool error) {
+	if (transmitting_) {
+		return;
+	}
+
+	lastMicros_ = now;
+
+	if (complete_) {
+		if (position_ < length_) {
+			return;
+		}
+
+		start = true;
+	}
+
+	if (start) {
+		length_ = 0;
+		complete_ = false;
+		error_ = false;
+	}
+
+	if (length_ < MAX_FRAME) {
+		buffer_[length_++] = data;
+	} else {
+		error_ = true;
+	}
+
+	error_ = error_ || error;
+}
+
+bool RS485::frameComplete() {
+	bool complete;
+	bool silent = quiet();
+
+	if (awaitingResponse_) {
+		checkResponseTimeout();
+	}
+
+	noInterrupts();
+	if (!complete_ && length_ > 0 && silent) {
+		complete_ = true;
+		position_ = 0;
+		frameMicros_ = lastMicros_;
+	}
+	complete = complete_;
+	interrupts();
+
+	return complete;
+}
+
+/**
+ * The bus has been silent for 3.5 characters since the last byte.
+ */
+bool RS485::quiet() {
+	bool quiet;
+
+	poll();
+
+	noInterrupts();
+	quiet = (long)(quietMicros_ - lastMicros_) >= (long)gapMicros_;
+	interrupts();
+
+	return quiet;
+}
+
+/**
+ * Move bytes from a UART with its own buffer, so that they're timestamped
+ * soon after they're received.
+ */
+void RS485::poll() {
+	unsigned long now = micros();
+	bool start;
+
+	if (uart_.available() <= 0) {
+		quietMicros_ = now;
+		return;
+	}
+
+	// These bytes could have been waiting since the UART was last seen to be
+	// empty, so they're only a new frame if the bus was quiet before then
+	start = (long)(quietMicros_ - lastMicros_) >= (long)gapMicros_;
+	do {
+		append(uart_.read(), now, start, false);
+		start = false;
+	} while (uart_.available() > 0);
+}
+
+void RS485::checkResponseTimeout() {
+	uint8_t response[5] = { request_[0], (uint8_t)(request_[1] | EXCEPTION_FUNCTION), GATEWAY_TARGET_FAILED };
+	CRC16 crc;
+	bool started;
+
+	noInterrupts();
+	started = length_ > 0;
+	interrupts();
+
+	if (started) {
+		awaitingResponse_ = false;
+		return;
+	} else if (responseTimeout_ == 0 || millis() - requestMillis_ < responseTimeout_) {
+		return;
+	}
+
+	crc.update(response, 3);
+	response[3] = crc.value() & 0xFF;
+	response[4] = crc.value() >> 8;
+
+	noInterrupts();
+	if (length_ == 0) {
+		for (uint8_t i = 0; i < sizeof(response); i++) {
+			buffer_[i] = response[i];
+		}
+		length_ = sizeof(response);
+		complete_ = true;
+		position_ = 0;
+	}
+	interrupts();
+
+	awaitingResponse_ = false;
+}
+
+int RS485::available() {
+	int count = 0;
+
+	if (frameComplete() && prefetch_ == Prefetch::NONE) {
+		noInterrupts();
+		if (complete_) {
+			count = length_ - position_;
+		}
+		interrupts();
+	}
+
+	return count;
+}
+
+int RS485::read() {
+	int data = -1;
+
+	if (frameComplete() && prefetch_ == Prefetch::NONE) {
+		noInterrupts();
+		if (complete_ && position_ < length_) {
+			data = buffer_[position_++];
+		}
+		interrupts();
+	}
+
+	return data;
+}
+
+int RS485::peek() {
+	int data = -1;
+
+	if (frameComplete() && prefetch_ == Prefetch::NONE) {
+		noInterrupts();
+		if (complete_ && position_ < length_) {
+			data = buffer_[position_];
+		}
+		interrupts();
+	}
+
+	return data;
+}
+
+size_t RS485::write(uint8_t data) {
+	if (prefetch_ == Prefetch::MATCHING) {
+		if (prefetchMatched_ < sizeof(lastRequest_) && data == lastRequest_[prefetchMatched_]) {
+			prefetchMatched_++;
+			return 1;
+		}
+
+		transmitPrefetched();
+	}
+
+	if (transmitting_ && requestLength_ < UINT8_MAX) {
+		if (requestLength_ < sizeof(request_)) {
+			request_[requestLength_] = data;
+		}
+		requestLength_++;
+	}
+
+	written_ = true;
+	return uart_.write(data);
+}
+
+void RS485::flush() {
+	uart_.flush();
+
+	if (written_) {
+#ifdef ARDUINO_ARCH_ESP8266
+		// The core only waits for the FIFO to be empty, not the last character
+		delayMicroseconds(charMicros_);
+#endif
+		written_ = false;
+	}
+}
@@ -0,0 +1,141 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef POWER_METER_RS485_HPP
+#define POWER_METER_RS485_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+#include "CRC16.hpp"
+
+/**
+Modbus RTU framing on an RS485 bus.
+
+Received bytes are assembled into whole frames, which are only made
+available to read once the bus has been silent for 3.5 characters
+(Modbus RTU end of frame). Bytes can be passed to receive() from the
+UART receive interrupt or, for a UART with its own interrupt-driven
+buffer, they're moved from it whenever this is polled.
+
+Polled bytes could have arrived at any time since the UART was last
+seen to be empty, so silence is only counted from then and a late poll
+can delay the end of a frame but can't split it. A complete frame is
+kept until it has been read (or the next transmission begins) and any
+bytes received in the meantime are discarded.
+
+If no response has started within the response timeout after a request
+was transmitted, a Modbus exception response (gateway target device
+failed to respond) is made available instead, so that ModbusMaster
+returns a failure without waiting for its own fixed timeout.
+
+The times that the last request finished transmitting and that the
+last byte of the most recent frame was received are available so that
+the meter's response latency can be measured without the time spent in
+ModbusMaster or waiting for the end of the frame.
+
+The last read request can be transmitted again in advance with
+prefetch(), so that the meter responds while the caller waits for
+something else (e.g. a transaction on another bus). Until the same
+request is next written, the response is hidden, and then that request
+is not transmitted and the response is read instead. Any other request
+is transmitted normally after the prefetched response.
+
+The transmitter is enabled once the bus has been silent for 3.5
+characters since the last frame (or after waiting for the longest
+possible frame, if it never is) and disabled as soon as the UART has
+finished transmitting.
+*/
+class RS485 final: public Stream {
+public:
+	RS485(Stream &uart, int dePin, int rePin);
+	virtual ~RS485();
+	void begin(unsigned long baudRate);
+	void beginTransmission();
+	void endTransmission();
+	void receive(uint8_t data, unsigned long now, bool error);
+	void setResponseTimeout(unsigned long timeout);
+	bool prefetch();
+	void poll();
+	unsigned long requestMicros() const;
+	unsigned long frameMicros() const;
+
+	int available() override;
+	int read() override;
+	int peek() override;
+	size_t write(uint8_t data) override;
+	void flush() override;
+	using Print::write;
+
+	static constexpr size_t MAX_FRAME = 256; ///< Maximum Modbus RTU frame length
+	static constexpr unsigned int CHAR_BITS = 10; ///< 8N1
+	static constexpr unsigned int INTER_FRAME_BITS = CHAR_BITS * 7 / 2;
+	static constexpr unsigned long MAX_BAUD_RATE_TIMING = 19200; ///< Fixed timing above this rate
+	static constexpr unsigned long FIXED_INTER_FRAME_MICROS = 1750;
+	static constexpr size_t READ_REQUEST_LENGTH = 8; ///< Address, function, start, count and CRC
+	static constexpr uint8_t BROADCAST_ADDRESS = 0x00;
+	static constexpr uint8_t READ_HOLDING_REGISTERS = 0x03;
+	static constexpr uint8_t READ_INPUT_REGISTERS = 0x04;
+	static constexpr uint8_t EXCEPTION_FUNCTION = 0x80;
+	static constexpr uint8_t GATEWAY_TARGET_FAILED = 0x0B; ///< Modbus exception code
+
+private:
+	enum class Prefetch : uint8_t {
+		NONE,
+		SENT, ///< The response is hidden
+		MATCHING, ///< The request being written is compared to the prefetched request
+	};
+
+	void startTransmission();
+	void transmitPrefetched();
+	void append(uint8_t data, unsigned long now, bool start, bool error);
+	bool frameComplete();
+	bool quiet();
+	void checkResponseTimeout();
+
+	Stream &uart_;
+	const int dePin_;
+	const int rePin_;
+	unsigned long charMicros_ = 0;
+	unsigned long gapMicros_ = 0; ///< Silence between frames (3.5 characters)
+	volatile bool transmitting_ = false;
+	bool written_ = false; ///< Data has been written since the last flush
+	uint8_t request_[READ_REQUEST_LENGTH]; ///< Start of the request
+	uint8_t requestLength_ = 0;
+	uint8_t lastRequest_[READ_REQUEST_LENGTH]; ///< Last read request, for prefetch()
+	bool lastRequestValid_ = false;
+	Prefetch prefetch_ = Prefetch::NONE;
+	uint8_t prefetchMatched_ = 0; ///< Bytes of the request that matched the prefetched request
+	bool awaitingResponse_ = false;
+	unsigned long requestMillis_ = 0; ///< Time the request was transmitted
+	unsigned long requestMicros_ = 0;
+	unsigned long frameMicros_ = 0; ///< Time of the last byte of the most recent frame
+	unsigned long responseTimeout_ = 0; ///< ms (0 to wait indefinitely)
+
+	// Updated by receive(), which could be in an interrupt
+	volatile uint8_t buffer_[MAX_FRAME];
+	volatile uint16_t length_ = 0;
+	volatile bool complete_ = false;
+	volatile bool error_ = false; ///< UART error or frame too long
+	volatile unsigned long lastMicros_ = 0; ///< Time of the last byte on the bus
+	volatile uint16_t position_ = 0; ///< Next byte to be read
+
+	unsigned long quietMicros_ = 0; ///< Time the UART was last polled with nothing to read
+};
+
+#endif
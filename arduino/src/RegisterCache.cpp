@@ -0,0 +1,78 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "RegisterCache.hpp"
+
+RegisterCache::RegisterCache() {
+
+}
+
+void RegisterCache::store(uint8_t function __attribute__((unused)), uint16_t start __attribute__((unused)),
+		uint16_t count __attribute__((unused)), ModbusMaster &modbus __attribute__((unused))) {
+#ifdef ARDUINO_ARCH_ESP8266
+	if (function != function_) {
+		function_ = function;
+		present_ = 0;
+	}
+
+	for (uint16_t i = 0; i < count && start + i < SIZE; i++) {
+		values_[start + i] = modbus.getResponseBuffer(i);
+		present_ |= 1ULL << (start + i);
+	}
+
+	updated_ = millis();
+#endif
+}
+
+bool RegisterCache::read(uint8_t function __attribute__((unused)), uint16_t start __attribute__((unused)),
+		uint16_t count __attribute__((unused)), uint8_t *data __attribute__((unused))) const {
+#ifdef ARDUINO_ARCH_ESP8266
+	if (function != function_ || count == 0 || start >= SIZE || count > SIZE - start) {
+		return false;
+	}
+
+	for (uint16_t i = 0; i < count; i++) {
+		if (!(present_ & (1ULL << (start + i)))) {
+			return false;
+		}
+
+		// Big-endian (as in a Modbus response)
+		*data++ = values_[start + i] >> 8;
+		*data++ = values_[start + i] & 0xFF;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint8_t RegisterCache::function() const {
+#ifdef ARDUINO_ARCH_ESP8266
+	return function_;
+#else
+	return 0;
+#endif
+}
+
+unsigned long RegisterCache::updated() const {
+#ifdef ARDUINO_ARCH_ESP8266
+	return updated_;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,58 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef POWER_METER_REGISTERCACHE_HPP
+#define POWER_METER_REGISTERCACHE_HPP
+
+#include <stdint.h>
+#include <Arduino.h>
+#include <ModbusMaster.h>
+
+/**
+Copy of the meter's registers from the last successful reads, in the
+same layout as the meter, so that they can be served to other Modbus
+clients without any access to the RS485 bus.
+
+Each read is stored as a whole so that the values are always from the
+same response. Only registers 0x0000 to SIZE - 1 read using one function
+(read holding or input registers) are stored.
+
+Only available on the ESP8266 (where there's a network to serve them on
+and enough RAM).
+*/
+class RegisterCache {
+public:
+	RegisterCache();
+	void store(uint8_t function, uint16_t start, uint16_t count, ModbusMaster &modbus);
+	bool read(uint8_t function, uint16_t start, uint16_t count, uint8_t *data) const;
+	uint8_t function() const;
+	unsigned long updated() const; ///< Time of the last store (ms)
+
+	static constexpr uint8_t READ_HOLDING_REGISTERS = 0x03;
+	static constexpr uint8_t READ_INPUT_REGISTERS = 0x04;
+	static constexpr uint16_t SIZE = 0x30;
+
+private:
+#ifdef ARDUINO_ARCH_ESP8266
+	uint8_t function_ = 0;
+	uint64_t present_ = 0; ///< Bitmap of registers that have been read
+	uint16_t values_[SIZE] = {};
+	unsigned long updated_ = 0;
+#endif
+};
+
+#endif
@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017  Simon Arlott
+ * Copyright 2017,2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -33,16 +33,16 @@ void Settings::init() {
 #endif
 	EEPROM.get(0, data);
 
-	output->print("# EEPROM magic = ");
+	output->print(F("# EEPROM magic = "));
 	output->print(data.magic, HEX);
-	output->print(", length = ");
+	output->print(F(", length = "));
 	output->print(data.length);
 
 	if (data.magic != EEPROM_MAGIC) {
-		output->println("; invalid");
+		output->println(F("; invalid"));
 		data.length = 0;
 	} else {
-		output->println("; valid");
+		output->println(F("; valid"));
 	}
 
 	if (data.length < sizeof(data)) {
@@ -98,8 +98,53 @@ void Settings::writeNTPHostname(unsigned int id, const String &value) {
 	}
 }
 
+bool Settings::readLastConnection(unsigned int &id, uint8_t bssid[], int32_t &channel) {
+	ConnectionData &connection = data.lastConnection;
+
+	connection.wifiSSID[sizeof(connection.wifiSSID) - 1] = 0;
+	if (connection.network >= MAX_NETWORKS || connection.channel <= 0
+			|| strlen(connection.wifiSSID) == 0
+			|| strcmp(connection.wifiSSID, readWiFiSSID(connection.network))) {
+		return false;
+	}
+
+	id = connection.network;
+	memcpy(bssid, connection.bssid, sizeof(connection.bssid));
+	channel = connection.channel;
+	return true;
+}
+
+bool Settings::writeLastConnection(unsigned int id, const uint8_t bssid[], int32_t channel) {
+	ConnectionData connection;
+
+	if (id >= MAX_NETWORKS) {
+		return false;
+	}
+
+	memset(&connection, 0, sizeof(connection));
+	connection.network = id;
+	strncpy(connection.wifiSSID, readWiFiSSID(id), sizeof(connection.wifiSSID) - 1);
+	memcpy(connection.bssid, bssid, sizeof(connection.bssid));
+	connection.channel = channel;
+
+	// Avoid unnecessary flash writes when reconnecting to the same network
+	if (memcmp(&connection, &data.lastConnection, sizeof(connection))) {
+		data.lastConnection = connection;
+		return true;
+	}
+	return false;
+}
+
+bool Settings::clearLastConnection() {
+	if (data.lastConnection.channel != 0) {
+		memset(&data.lastConnection, 0, sizeof(data.lastConnection));
+		return true;
+	}
+	return false;
+}
+
 void Settings::commit() {
-	output->println("# EEPROM commit");
+	output->println(F("# EEPROM commit"));
 	EEPROM.put(0, data);
 #ifdef ARDUINO_ARCH_ESP8266
 	EEPROM.commit();
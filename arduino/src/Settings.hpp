@@ -1,6 +1,6 @@
 /*
  * power-meter - Arduino Power Meter Modbus Client
- * Copyright 2017  Simon Arlott
+ * Copyright 2017,2026  Simon Arlott
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -34,12 +34,16 @@ public:
 	static void writeWiFiPassphrase(unsigned int id, const String &value);
 	static const char* readNTPHostname(unsigned int id);
 	static void writeNTPHostname(unsigned int id, const String &value);
+	static bool readLastConnection(unsigned int &id, uint8_t bssid[], int32_t &channel);
+	static bool writeLastConnection(unsigned int id, const uint8_t bssid[], int32_t channel);
+	static bool clearLastConnection();
 	static void commit();
 
 	static constexpr unsigned int MAX_NETWORKS = 10;
 	static constexpr unsigned int MAX_HOSTNAME_LEN = 64;
 	static constexpr unsigned int IEEE80211_MAX_SSID_LEN = 32;
 	static constexpr unsigned int WPA2_PSK_MAX_PASSPHRASE_LEN = 63;
+	static constexpr unsigned int BSSID_LEN = 6;
 
 protected:
 	static constexpr uint32_t EEPROM_MAGIC = 0x16021766;
@@ -61,10 +65,23 @@ protected:
 		};
 	};
 
+	/**
+	 * Access point of the last successful connection, so that reconnecting
+	 * doesn't need to scan for networks. Invalid if the network ID is out
+	 * of range or the SSID has changed.
+	 */
+	struct ConnectionData {
+		uint8_t network;
+		char wifiSSID[IEEE80211_MAX_SSID_LEN + 1];
+		uint8_t bssid[BSSID_LEN];
+		int32_t channel;
+	} __attribute__((packed));
+
 	struct Data {
 		uint32_t magic;
 		uint16_t length;
 		NetworkData networks[MAX_NETWORKS];
+		ConnectionData lastConnection;
 	} __attribute__((packed));
 
 	static Data data;
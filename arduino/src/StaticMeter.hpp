@@ -0,0 +1,50 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_STATICMETER_HPP
+#define POWER_METER_STATICMETER_HPP
+
+#include <Arduino.h>
+
+/**
+Meter driver that is bound at compile time (POWER_METER_STATIC).
+
+The driver's functions are called by their qualified names, which
+bypasses the vtable, and the class is final so that calls to it through
+its own type don't need to use the vtable either. This allows the
+compiler to inline the read and output path for the driver.
+*/
+template <class Meter>
+class StaticMeter final: public Meter {
+public:
+	using Meter::Meter;
+
+	bool read() {
+		return this->readWith([this] { return Meter::readSerialNumber(); }, [this] { return Meter::readMeasurements(); });
+	}
+
+	size_t printTo(Print &p) const override __attribute__((warn_unused_result)) {
+		return PowerMeter::printTo(p, Meter::model());
+	}
+
+	size_t writeFrameTo(Print &p, uint16_t sequence) const __attribute__((warn_unused_result)) {
+		return PowerMeter::writeFrameTo(p, sequence, Meter::model());
+	}
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WebPage.hpp"
+
+WebPage::WebPage(const Section *sections, size_t count, Field field)
+		: sections_(sections), count_(count), field_(field) {
+	scratch_[0] = 0;
+}
+
+const char *WebPage::escape(char c) {
+	switch (c) {
+	case '&': return "&amp;";
+	case '<': return "&lt;";
+	case '>': return "&gt;";
+	case '"': return "&quot;";
+	case '\'': return "&#39;";
+	default: return nullptr;
+	}
+}
+
+size_t WebPage::read(uint8_t *buffer, size_t length) {
+	size_t n = 0;
+
+	while (n < length) {
+		if (value_) {
+			char c = value_[valuePos_];
+
+			if (!c) {
+				value_ = nullptr;
+				continue;
+			}
+
+			const char *entity = escape(c);
+			if (entity) {
+				size_t entityLength = strlen(entity);
+
+				// Continue in the next chunk
+				if (n + entityLength > length) {
+					break;
+				}
+
+				memcpy(&buffer[n], entity, entityLength);
+				n += entityLength;
+			} else {
+				buffer[n++] = c;
+			}
+			valuePos_++;
+			continue;
+		}
+
+		if (section_ >= count_) {
+			break;
+		}
+
+		char c = pgm_read_byte(sections_[section_].text + pos_);
+		if (!c) {
+			pos_ = 0;
+			if (++index_ >= sections_[section_].repeat) {
+				index_ = 0;
+				section_++;
+			}
+			continue;
+		}
+
+		pos_++;
+		if ((uint8_t)c < ' ') {
+			value_ = field_ ? field_(c, index_, scratch_, sizeof(scratch_)) : nullptr;
+			valuePos_ = 0;
+		} else {
+			buffer[n++] = c;
+		}
+	}
+
+	return n;
+}
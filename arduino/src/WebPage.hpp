@@ -0,0 +1,68 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_WEBPAGE_HPP
+#define POWER_METER_WEBPAGE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+/**
+Web page rendered from templates in flash, a chunk at a time.
+
+The page is a list of sections, each of which is a PROGMEM template that
+is output a number of times. Control characters (1-31) in a template are
+replaced by the value of that field for the current repetition, which is
+HTML escaped. Values are RAM strings returned by the field function, which
+can format them into the scratch buffer. Each chunk must have room for at
+least one escaped character (6 bytes) or the page will end early.
+
+The state is small enough to be copied into the response callback so no
+memory is allocated while the page is output and the page size doesn't
+affect memory use.
+*/
+class WebPage {
+public:
+	static constexpr size_t SCRATCH_SIZE = 16;
+
+	struct Section {
+		PGM_P text;
+		unsigned int repeat;
+	};
+
+	typedef const char *(*Field)(char field, unsigned int index, char *scratch, size_t size);
+
+	WebPage(const Section *sections, size_t count, Field field = nullptr);
+	size_t read(uint8_t *buffer, size_t length);
+
+private:
+	static const char *escape(char c);
+
+	const Section *sections_;
+	size_t count_;
+	Field field_;
+	size_t section_ = 0;
+	unsigned int index_ = 0;
+	size_t pos_ = 0;
+	const char *value_ = nullptr;
+	size_t valuePos_ = 0;
+	char scratch_[SCRATCH_SIZE];
+};
+
+#endif
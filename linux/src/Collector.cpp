@@ -0,0 +1,297 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Collector.hpp"
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string_view>
+
+#include "Reading.hpp"
+#include "ReadingParser.hpp"
+
+Collector::Collector(LocalServer &server, SharedReadings &shared, unsigned int threads)
+		: server_(server), shared_(shared) {
+	for (unsigned int i = 0; i < threads; i++) {
+		workers_.push_back(std::make_unique<Worker>());
+	}
+}
+
+Collector::~Collector() {
+	stop();
+}
+
+int Collector::openSocket(unsigned int shard) {
+	struct sockaddr_in addr{};
+	struct ip_mreqn mreq{};
+	struct timeval timeout{1, 0};
+	int enable = 1;
+	int fd;
+
+	fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+	if (fd < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(PORT);
+	inet_pton(AF_INET, IP4_GROUP, &addr.sin_addr);
+	mreq.imr_multiaddr = addr.sin_addr;
+	mreq.imr_address.s_addr = htonl(INADDR_ANY);
+
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable))
+			|| setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable))
+			|| setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable))
+			|| setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout))) {
+		perror("setsockopt");
+		close(fd);
+		return -1;
+	}
+
+	if (workers_.size() > 1) {
+		struct sock_filter code[] = {
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t)SKF_NET_OFF + 12), // Source address
+			BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32_t)workers_.size()),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, shard, 0, 1),
+			BPF_STMT(BPF_RET | BPF_K, UINT32_MAX),
+			BPF_STMT(BPF_RET | BPF_K, 0),
+		};
+		struct sock_fprog filter{sizeof(code) / sizeof(code[0]), code};
+
+		if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter))) {
+			perror("SO_ATTACH_FILTER");
+			close(fd);
+			return -1;
+		}
+	}
+
+	// This is limited by net.core.rmem_max, so failure isn't fatal
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &RECEIVE_BUFFER, sizeof(RECEIVE_BUFFER));
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		perror("bind");
+		close(fd);
+		return -1;
+	}
+
+	if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq))) {
+		perror("IP_ADD_MEMBERSHIP");
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+bool Collector::start() {
+	for (unsigned int i = 0; i < workers_.size(); i++) {
+		workers_[i]->fd = openSocket(i);
+		if (workers_[i]->fd < 0) {
+			stop();
+			return false;
+		}
+	}
+
+	running_ = true;
+	for (auto &worker : workers_) {
+		worker->thread = std::thread{&Collector::run, this, std::ref(*worker)};
+	}
+	return true;
+}
+
+void Collector::stop() {
+	running_ = false;
+
+	for (auto &worker : workers_) {
+		if (worker->thread.joinable()) {
+			worker->thread.join();
+		}
+
+		if (worker->fd >= 0) {
+			close(worker->fd);
+			worker->fd = -1;
+		}
+	}
+}
+
+Collector::Statistics Collector::statistics() const {
+	Statistics total;
+
+	for (auto &worker : workers_) {
+		total.datagrams += worker->datagrams;
+		total.readings += worker->readings;
+		total.invalid += worker->invalid;
+		total.kernelDrops += worker->kernelDrops;
+	}
+
+	return total;
+}
+
+static uint64_t microseconds(const struct timespec &ts) {
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void Collector::run(Worker &worker) {
+	// A datagram may contain several readings, each published separately
+	constexpr size_t SOURCE_LENGTH = sizeof(in_addr_t);
+	constexpr size_t OUTPUT_LENGTH = SOURCE_LENGTH + Reading::MAX_LENGTH;
+	constexpr unsigned int MAX_OUTPUT = BATCH_SIZE;
+	constexpr size_t CONTROL_LENGTH = CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(struct timespec));
+
+	struct Input {
+		uint8_t data[Reading::MAX_LENGTH];
+		uint8_t control[CONTROL_LENGTH];
+		struct sockaddr_in source;
+		struct iovec iov;
+	};
+
+	struct Output {
+		uint8_t data[OUTPUT_LENGTH];
+		struct iovec iov;
+	};
+
+	std::vector<Input> input(BATCH_SIZE);
+	std::vector<struct mmsghdr> inputMessages(BATCH_SIZE);
+	std::vector<Output> output(MAX_OUTPUT);
+	std::vector<struct mmsghdr> outputMessages(MAX_OUTPUT);
+
+	for (unsigned int i = 0; i < BATCH_SIZE; i++) {
+		input[i].iov = {input[i].data, sizeof(input[i].data)};
+	}
+
+	for (unsigned int i = 0; i < MAX_OUTPUT; i++) {
+		output[i].iov = {output[i].data, 0};
+		outputMessages[i] = {};
+		outputMessages[i].msg_hdr.msg_iov = &output[i].iov;
+		outputMessages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (running_) {
+		unsigned int outputs = 0;
+		int count;
+
+		for (unsigned int i = 0; i < BATCH_SIZE; i++) {
+			struct msghdr &hdr = inputMessages[i].msg_hdr;
+
+			hdr = {};
+			hdr.msg_name = &input[i].source;
+			hdr.msg_namelen = sizeof(input[i].source);
+			hdr.msg_iov = &input[i].iov;
+			hdr.msg_iovlen = 1;
+			hdr.msg_control = input[i].control;
+			hdr.msg_controllen = sizeof(input[i].control);
+		}
+
+		count = recvmmsg(worker.fd, inputMessages.data(), BATCH_SIZE, MSG_WAITFORONE, nullptr);
+		if (count < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				perror("recvmmsg");
+			}
+			continue;
+		}
+
+		worker.datagrams += count;
+
+		for (int i = 0; i < count; i++) {
+			struct msghdr &hdr = inputMessages[i].msg_hdr;
+			const uint8_t *data = input[i].data;
+			size_t length = inputMessages[i].msg_len;
+			uint64_t timestamp = 0;
+			Reading reading;
+
+			for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+				if (cmsg->cmsg_level != SOL_SOCKET) {
+					continue;
+				}
+
+				if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+					uint32_t drops;
+
+					memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+					worker.kernelDrops = drops;
+				} else if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+					struct timespec ts;
+
+					memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+					timestamp = microseconds(ts);
+				}
+			}
+
+			auto add = [&] () {
+				Output &out = output[outputs];
+				size_t encoded;
+
+				if (reading.timestamp == 0) {
+					reading.timestamp = timestamp;
+				}
+
+				encoded = reading.encode(out.data + SOURCE_LENGTH, sizeof(out.data) - SOURCE_LENGTH);
+				if (encoded == 0) {
+					worker.invalid++;
+					return;
+				}
+
+				memcpy(out.data, &input[i].source.sin_addr.s_addr, SOURCE_LENGTH);
+				out.iov.iov_len = SOURCE_LENGTH + encoded;
+				worker.readings++;
+
+				shared_.publish(reading.serialNumber, reading.timestamp, out.data, out.iov.iov_len);
+
+				if (++outputs == MAX_OUTPUT) {
+					server_.publish(outputMessages.data(), outputs);
+					outputs = 0;
+				}
+			};
+
+			if (length > 0 && data[0] == Reading::DATAGRAM_MARKER) {
+				if (reading.decode(data, length)) {
+					if (!reading.serialNumber.empty()) {
+						add();
+					}
+				} else {
+					worker.invalid++;
+				}
+			} else {
+				ReadingParser parser{std::string_view{(const char *)data, length}};
+
+				while (!parser.finished()) {
+					if (!parser.next(reading)) {
+						worker.invalid++;
+						break;
+					}
+
+					if (!reading.serialNumber.empty()) {
+						add();
+					}
+				}
+			}
+		}
+
+		server_.publish(outputMessages.data(), outputs);
+	}
+}
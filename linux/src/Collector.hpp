@@ -0,0 +1,82 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_COLLECTOR_HPP
+#define POWER_METER_COLLECTOR_HPP
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "LocalServer.hpp"
+#include "SharedReadings.hpp"
+
+/**
+Receives readings from the multicast group on one or more threads.
+
+Each thread has its own socket. Multicast datagrams are delivered to
+every socket (SO_REUSEPORT doesn't distribute them), so each socket has
+a filter that only accepts datagrams from a subset of senders (and
+therefore of meters) by IPv4 source address.
+
+Datagrams are received in batches with recvmmsg() and every reading is
+published to the LocalServer and SharedReadings in binary form.
+*/
+class Collector {
+public:
+	struct Statistics {
+		uint64_t datagrams = 0;
+		uint64_t readings = 0;
+		uint64_t invalid = 0;
+		uint64_t kernelDrops = 0; ///< SO_RXQ_OVFL
+	};
+
+	Collector(LocalServer &server, SharedReadings &shared, unsigned int threads);
+	~Collector();
+	bool start();
+	void stop();
+	Statistics statistics() const;
+
+	static constexpr const char *IP4_GROUP = "239.192.160.217";
+	static constexpr uint16_t PORT = 16021;
+	static constexpr unsigned int BATCH_SIZE = 64;
+	static constexpr int RECEIVE_BUFFER = 4 * 1024 * 1024;
+
+private:
+	struct Worker {
+		int fd = -1;
+		std::thread thread;
+		std::atomic<uint64_t> datagrams{0};
+		std::atomic<uint64_t> readings{0};
+		std::atomic<uint64_t> invalid{0};
+		std::atomic<uint32_t> kernelDrops{0};
+	};
+
+	int openSocket(unsigned int shard);
+	void run(Worker &worker);
+
+	LocalServer &server_;
+	SharedReadings &shared_;
+	std::atomic<bool> running_{false};
+	std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocalServer.hpp"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+LocalServer::LocalServer() {
+
+}
+
+LocalServer::~LocalServer() {
+	stop();
+}
+
+bool LocalServer::open(const std::string &path) {
+	struct sockaddr_un addr{};
+	struct timeval timeout{1, 0};
+
+	if (path.length() >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket path too long: %s\n", path.c_str());
+		return false;
+	}
+
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+	fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd_ < 0) {
+		perror("socket");
+		return false;
+	}
+
+	unlink(path.c_str());
+	if (bind(fd_, (struct sockaddr *)&addr, sizeof(addr))) {
+		perror(path.c_str());
+		return false;
+	}
+	path_ = path;
+
+	if (listen(fd_, SOMAXCONN)) {
+		perror("listen");
+		return false;
+	}
+
+	// Wake up regularly to check if the server has been stopped
+	setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	running_ = true;
+	thread_ = std::thread{&LocalServer::run, this};
+	return true;
+}
+
+void LocalServer::stop() {
+	running_ = false;
+
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+
+	if (fd_ >= 0) {
+		close(fd_);
+		fd_ = -1;
+	}
+
+	if (!path_.empty()) {
+		unlink(path_.c_str());
+		path_.clear();
+	}
+
+	std::lock_guard<std::mutex> lock{mutex_};
+	for (int client : clients_) {
+		close(client);
+	}
+	clients_.clear();
+}
+
+void LocalServer::run() {
+	while (running_) {
+		int client = accept4(fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (client < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				perror("accept");
+			}
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock{mutex_};
+		clients_.push_back(client);
+	}
+}
+
+void LocalServer::publish(struct mmsghdr *messages, unsigned int count) {
+	std::lock_guard<std::mutex> lock{mutex_};
+
+	if (count == 0) {
+		return;
+	}
+
+	for (auto it = clients_.begin(); it != clients_.end(); ) {
+		unsigned int sent = 0;
+		bool failed = false;
+
+		while (sent < count) {
+			int ret = sendmmsg(*it, &messages[sent], count - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+			if (ret < 0) {
+				if (errno == EINTR) {
+					continue;
+				} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+					failed = true;
+				}
+				break;
+			}
+
+			sent += ret;
+		}
+
+		dropped_ += count - sent;
+
+		if (failed) {
+			close(*it);
+			it = clients_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+uint64_t LocalServer::dropped() const {
+	return dropped_;
+}
+
+size_t LocalServer::clients() {
+	std::lock_guard<std::mutex> lock{mutex_};
+	return clients_.size();
+}
@@ -0,0 +1,66 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_LOCALSERVER_HPP
+#define POWER_METER_LOCALSERVER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+Local (Unix SOCK_SEQPACKET) socket that publishes every reading to all
+connected clients.
+
+Each message is the 4-byte IPv4 address of the sender followed by a
+binary datagram (see Reading::encode()).
+
+Clients that aren't keeping up lose messages instead of blocking the
+collector.
+*/
+class LocalServer {
+public:
+	LocalServer();
+	~LocalServer();
+	bool open(const std::string &path);
+	void stop();
+	void publish(struct mmsghdr *messages, unsigned int count);
+	uint64_t dropped() const;
+	size_t clients();
+
+	static constexpr const char *DEFAULT_PATH = "/run/power-meter-collector";
+
+private:
+	void run();
+
+	std::string path_;
+	int fd_ = -1;
+	std::atomic<bool> running_{false};
+	std::thread thread_;
+	std::mutex mutex_;
+	std::vector<int> clients_;
+	std::atomic<uint64_t> dropped_{0};
+};
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MulticastSender.hpp"
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+MulticastSender::MulticastSender() {
+
+}
+
+MulticastSender::~MulticastSender() {
+	close();
+}
+
+bool MulticastSender::open(const std::string &interface) {
+	struct ip_mreqn mreq{};
+	int ttl = TTL;
+
+	close();
+
+	fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+	if (fd_ < 0) {
+		perror("socket");
+		return false;
+	}
+
+	if (setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl))) {
+		perror("setsockopt");
+		close();
+		return false;
+	}
+
+	// Transmit on a specific interface from any IP
+	if (!interface.empty()) {
+		mreq.imr_address.s_addr = htonl(INADDR_ANY);
+		mreq.imr_ifindex = if_nametoindex(interface.c_str());
+		if (mreq.imr_ifindex == 0) {
+			perror(interface.c_str());
+			close();
+			return false;
+		}
+
+		if (setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &mreq, sizeof(mreq))) {
+			perror("setsockopt");
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MulticastSender::close() {
+	if (fd_ != -1) {
+		::close(fd_);
+		fd_ = -1;
+	}
+
+	bufferLength_ = 0;
+}
+
+size_t MulticastSender::write(uint8_t c) {
+	if (c == '\r' || c == '\n') {
+		sendPacket();
+		return 1;
+	}
+
+	if (bufferLength_ < MAX_LENGTH) {
+		buffer_[bufferLength_++] = c;
+		return 1;
+	} else {
+		return 0;
+	}
+}
+
+void MulticastSender::sendPacket() {
+	if (bufferLength_ > 0 && fd_ != -1) {
+		struct sockaddr_in addr{};
+
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(PORT);
+		inet_pton(AF_INET, IP4_GROUP, &addr.sin_addr);
+
+		if (sendto(fd_, buffer_, bufferLength_, MSG_NOSIGNAL, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+			perror("sendto");
+		}
+	}
+
+	bufferLength_ = 0;
+}
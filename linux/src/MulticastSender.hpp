@@ -0,0 +1,59 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_MULTICASTSENDER_HPP
+#define POWER_METER_MULTICASTSENDER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+#include <string>
+
+/**
+Publishes readings to the multicast group in the same way as
+EthernetNetwork: each line written is sent as one datagram (without the
+line ending).
+*/
+class MulticastSender final: public Print {
+public:
+	MulticastSender();
+	~MulticastSender() override;
+	bool open(const std::string &interface);
+	void close();
+	size_t write(uint8_t c) override;
+	using Print::write;
+
+	static constexpr const char *IP4_GROUP = "239.192.160.217";
+	static constexpr uint16_t PORT = 16021;
+	static constexpr int TTL = 1;
+
+	static constexpr size_t ETH_DATA_LEN = 1500;
+	static constexpr size_t IPV4_HLEN = 20;
+	static constexpr size_t UDP_HLEN = 8;
+	static constexpr size_t MAX_LENGTH = ETH_DATA_LEN - IPV4_HLEN - UDP_HLEN;
+
+private:
+	void sendPacket();
+
+	int fd_ = -1;
+	char buffer_[MAX_LENGTH];
+	size_t bufferLength_ = 0;
+};
+
+#endif
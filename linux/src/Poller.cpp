@@ -0,0 +1,147 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Poller.hpp"
+
+#include <strings.h>
+
+#include "Main.hpp"
+#include "OutputFormat.hpp"
+#include "PZEM_004T_100A.hpp"
+#include "RI_D19_80_C.hpp"
+
+Poller::Poller(const std::vector<Bus> &buses, const std::string &interface)
+		: interface_(interface) {
+	for (const Bus &bus : buses) {
+		workers_.push_back(std::make_unique<Worker>());
+		workers_.back()->bus = bus;
+	}
+}
+
+Poller::~Poller() {
+	stop();
+}
+
+bool Poller::parseModel(const std::string &name, Model &model) {
+	std::string value{name};
+
+	for (char &c : value) {
+		if (c == '_') {
+			c = '-';
+		}
+	}
+
+	if (!strcasecmp(value.c_str(), "RI-D19-80-C")) {
+		model = Model::RI_D19_80_C;
+		return true;
+	} else if (!strcasecmp(value.c_str(), "PZEM-004T-100A")) {
+		model = Model::PZEM_004T_100A;
+		return true;
+	}
+
+	return false;
+}
+
+bool Poller::start() {
+	for (size_t i = 0; i < workers_.size(); i++) {
+		Worker &worker = *workers_[i];
+
+		if (!worker.port.open(worker.bus.device, INPUT_BAUD_RATE)
+				|| !worker.sender.open(interface_)) {
+			return false;
+		}
+
+		switch (worker.bus.model) {
+		case Model::RI_D19_80_C:
+			worker.meter = std::make_unique<RI_D19_80_C>(worker.modbus, &worker.port, worker.bus.address);
+			break;
+
+		case Model::PZEM_004T_100A:
+			worker.meter = std::make_unique<PZEM_004T_100A>(worker.modbus, &worker.port, worker.bus.address);
+			break;
+		}
+
+		// Identify the meter in the readings (as the firmware does with a second bus)
+		if (workers_.size() > 1) {
+			worker.meter->setBus(i + 1, worker.bus.address);
+		}
+	}
+
+	running_ = true;
+	for (auto &worker : workers_) {
+		worker->thread = std::thread{&Poller::run, this, std::ref(*worker)};
+	}
+
+	return true;
+}
+
+void Poller::stop() {
+	{
+		std::lock_guard<std::mutex> lock{mutex_};
+		running_ = false;
+	}
+	stopped_.notify_all();
+
+	for (auto &worker : workers_) {
+		if (worker->thread.joinable()) {
+			worker->thread.join();
+		}
+	}
+}
+
+std::vector<Poller::Statistics> Poller::statistics() const {
+	std::vector<Statistics> stats;
+
+	for (const auto &worker : workers_) {
+		Statistics bus;
+
+		bus.readings = worker->readings;
+		bus.failures = worker->failures;
+		stats.push_back(bus);
+	}
+
+	return stats;
+}
+
+bool Poller::sleepUntil(std::chrono::system_clock::time_point time) {
+	std::unique_lock<std::mutex> lock{mutex_};
+
+	return !stopped_.wait_until(lock, time, [this] { return !running_; });
+}
+
+void Poller::run(Worker &worker) {
+	using std::chrono::system_clock;
+	system_clock::time_point next = system_clock::now();
+
+	while (sleepUntil(next)) {
+		bool due = worker.meter->health().due(millis());
+
+		if (worker.meter->read()) {
+			TextFormat::write(*worker.meter, worker.sender, 0);
+			worker.readings++;
+
+			next = std::chrono::ceil<std::chrono::seconds>(system_clock::now());
+		} else {
+			if (due) {
+				worker.failures++;
+			}
+
+			next = system_clock::now() + std::chrono::milliseconds(RETRY_MILLIS);
+		}
+	}
+}
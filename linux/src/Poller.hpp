@@ -0,0 +1,97 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_POLLER_HPP
+#define POWER_METER_POLLER_HPP
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ModbusMaster.h>
+
+#include "MulticastSender.hpp"
+#include "PowerMeter.hpp"
+#include "SerialPort.hpp"
+
+/**
+Reads meters on one or more RS485 buses using the firmware's meter
+drivers and publishes the readings to the multicast group.
+
+Each bus has its own thread, serial port, ModbusMaster and socket so that
+a slow or missing meter on one bus doesn't delay the others. Meters are
+read at the start of every second (by the system clock, which is what
+the ESP8266 does when it has the time from NTP) and reads that fail are
+retried after RETRY_MILLIS, subject to MeterHealth's backoff.
+*/
+class Poller {
+public:
+	enum class Model {
+		RI_D19_80_C,
+		PZEM_004T_100A,
+	};
+
+	struct Bus {
+		std::string device;
+		Model model = Model::RI_D19_80_C;
+		uint8_t address = 0x01;
+	};
+
+	struct Statistics {
+		uint64_t readings = 0;
+		uint64_t failures = 0;
+	};
+
+	Poller(const std::vector<Bus> &buses, const std::string &interface);
+	~Poller();
+	bool start();
+	void stop();
+	std::vector<Statistics> statistics() const;
+
+	static bool parseModel(const std::string &name, Model &model);
+
+private:
+	struct Worker {
+		Bus bus;
+		SerialPort port;
+		ModbusMaster modbus;
+		std::unique_ptr<PowerMeter> meter;
+		MulticastSender sender;
+		std::thread thread;
+		std::atomic<uint64_t> readings{0};
+		std::atomic<uint64_t> failures{0};
+	};
+
+	void run(Worker &worker);
+	bool sleepUntil(std::chrono::system_clock::time_point time);
+
+	std::string interface_;
+	std::atomic<bool> running_{false};
+	std::mutex mutex_;
+	std::condition_variable stopped_;
+	std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+#endif
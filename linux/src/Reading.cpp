@@ -0,0 +1,222 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Reading.hpp"
+
+#include <string.h>
+
+#include "CRC16.hpp"
+
+const char *const Reading::FIELD_NAMES[Reading::FIELDS] = {
+	"voltage",
+	"current",
+	"frequency",
+	"activePower",
+	"reactivePower",
+	"apparentPower",
+	"powerFactor",
+	"temperature",
+	"activeEnergy",
+	"reactiveEnergy",
+};
+
+int Reading::field(std::string_view name) {
+	for (unsigned int i = 0; i < FIELDS; i++) {
+		if (name == FIELD_NAMES[i]) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+bool Reading::hasValue(unsigned int field) const {
+	return field < FIELDS && (present & (1U << field));
+}
+
+void Reading::setValue(unsigned int field, int64_t coefficient, int8_t exponent) {
+	if (field < FIELDS) {
+		present |= 1U << field;
+		if (coefficient < 0) {
+			sign |= 1U << field;
+		} else {
+			sign &= ~(1U << field);
+		}
+		this->coefficient[field] = (uint32_t)coefficient;
+		this->exponent[field] = exponent;
+	}
+}
+
+static uint16_t get16(const uint8_t *data) {
+	return data[0] | (data[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *data) {
+	return get16(data) | ((uint32_t)get16(data + 2) << 16);
+}
+
+static uint64_t get64(const uint8_t *data) {
+	return get32(data) | ((uint64_t)get32(data + 4) << 32);
+}
+
+bool Reading::decode(const uint8_t *data, size_t length) {
+	const uint8_t *end = data + length;
+	uint8_t version;
+	CRC16 crc;
+
+	if (length < 1 + 8 + 3 + 2 || data[0] != DATAGRAM_MARKER) {
+		return false;
+	}
+
+	timestamp = get64(data + 1);
+	data += 1 + 8;
+
+	crc.update(data, end - data - 2);
+	if (crc.value() != get16(end - 2)) {
+		return false;
+	}
+	end -= 2;
+
+	version = data[0];
+	if (version != FRAME_VERSION && version != FRAME_VERSION_BUS) {
+		return false;
+	}
+	sequence = get16(data + 1);
+	data += 3;
+
+	for (std::string_view *value : { &model, &serialNumber }) {
+		if (data >= end || data + 1 + data[0] > end) {
+			return false;
+		}
+
+		*value = std::string_view{(const char *)data + 1, data[0]};
+		data += 1 + data[0];
+	}
+
+	if (version == FRAME_VERSION_BUS) {
+		if (data + 2 > end) {
+			return false;
+		}
+
+		bus = data[0];
+		address = data[1];
+		data += 2;
+	} else {
+		bus = 0;
+		address = 0;
+	}
+
+	if (data + 4 > end) {
+		return false;
+	}
+	present = get16(data) & ((1U << FIELDS) - 1);
+	sign = get16(data + 2) & present;
+	data += 4;
+
+	for (unsigned int i = 0; i < FIELDS; i++) {
+		if (hasValue(i)) {
+			if (data + 5 > end) {
+				return false;
+			}
+
+			exponent[i] = (int8_t)data[0];
+			coefficient[i] = get32(data + 1);
+			data += 5;
+		}
+	}
+
+	return data == end;
+}
+
+class Encoder {
+public:
+	Encoder(uint8_t *buffer, size_t length) : buffer_(buffer), length_(length) {}
+
+	void add(uint8_t value) {
+		if (pos_ < length_) {
+			buffer_[pos_] = value;
+		}
+		pos_++;
+	}
+
+	void add(uint16_t value) {
+		add((uint8_t)value);
+		add((uint8_t)(value >> 8));
+	}
+
+	void add(uint32_t value) {
+		add((uint16_t)value);
+		add((uint16_t)(value >> 16));
+	}
+
+	void add(uint64_t value) {
+		add((uint32_t)value);
+		add((uint32_t)(value >> 32));
+	}
+
+	void add(std::string_view value) {
+		if (value.length() > UINT8_MAX) {
+			value = value.substr(0, UINT8_MAX);
+		}
+
+		add((uint8_t)value.length());
+		for (char c : value) {
+			add((uint8_t)c);
+		}
+	}
+
+	size_t length() const { return pos_ <= length_ ? pos_ : 0; }
+
+private:
+	uint8_t *buffer_;
+	size_t length_;
+	size_t pos_ = 0;
+};
+
+size_t Reading::encode(uint8_t *buffer, size_t length) const {
+	Encoder frame{buffer, length};
+	CRC16 crc;
+
+	frame.add(DATAGRAM_MARKER);
+	frame.add(timestamp);
+	frame.add(bus > 0 ? FRAME_VERSION_BUS : FRAME_VERSION);
+	frame.add(sequence);
+	frame.add(model);
+	frame.add(serialNumber);
+	if (bus > 0) {
+		frame.add(bus);
+		frame.add(address);
+	}
+	frame.add(present);
+	frame.add(sign);
+
+	for (unsigned int i = 0; i < FIELDS; i++) {
+		if (hasValue(i)) {
+			frame.add((uint8_t)exponent[i]);
+			frame.add(coefficient[i]);
+		}
+	}
+
+	if (frame.length() == 0 || frame.length() + 2 > length) {
+		return 0;
+	}
+
+	crc.update(buffer + 1 + 8, frame.length() - 1 - 8);
+	frame.add(crc.value());
+	return frame.length();
+}
@@ -0,0 +1,66 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_READING_HPP
+#define POWER_METER_READING_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+/**
+A decoded reading, referring to the model and serial number in the
+received datagram.
+
+Values are kept as the coefficient and exponent that the meter output
+so that they can be passed on without any loss of precision.
+*/
+class Reading {
+public:
+	static constexpr unsigned int FIELDS = 10;
+	static const char *const FIELD_NAMES[FIELDS];
+
+	/** Binary datagram (see python/powermeter/__init__.py and arduino/src/BinaryFrame.hpp) */
+	static constexpr uint8_t DATAGRAM_MARKER = 0x00;
+	static constexpr uint8_t FRAME_VERSION = 1;
+	static constexpr uint8_t FRAME_VERSION_BUS = 2; ///< With the bus and address
+	static constexpr size_t MAX_LENGTH = 1500 - 20 - 8;
+
+	static int field(std::string_view name);
+
+	bool hasValue(unsigned int field) const;
+	void setValue(unsigned int field, int64_t coefficient, int8_t exponent);
+
+	/** Decode a binary datagram */
+	bool decode(const uint8_t *data, size_t length);
+	/** Encode a binary datagram, returning 0 if it doesn't fit */
+	size_t encode(uint8_t *buffer, size_t length) const;
+
+	std::string_view model;
+	std::string_view serialNumber;
+	uint64_t timestamp = 0; ///< µs since the epoch
+	uint16_t sequence = 0;
+	uint8_t bus = 0; ///< RS485 bus (0 if the device only has one)
+	uint8_t address = 0; ///< Modbus address (if there's a bus)
+	uint16_t present = 0;
+	uint16_t sign = 0;
+	int8_t exponent[FIELDS] = {};
+	uint32_t coefficient[FIELDS] = {};
+};
+
+#endif
@@ -0,0 +1,249 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReadingParser.hpp"
+
+#include <stdint.h>
+
+ReadingParser::ReadingParser(std::string_view text) : text_(text) {
+	whitespace();
+}
+
+bool ReadingParser::finished() const {
+	return text_.empty();
+}
+
+bool ReadingParser::next(Reading &reading) {
+	reading = Reading{};
+
+	if (!consume("meter: {model: ") || !string(reading.model)) {
+		return false;
+	}
+
+	if (consume(",serialNumber: ")) {
+		if (!string(reading.serialNumber)) {
+			return false;
+		}
+	}
+
+	if (consume(",bus: ")) {
+		if (!integer(reading.bus) || !consume(",address: ") || !integer(reading.address)) {
+			return false;
+		}
+	}
+
+	if (!consume(",reading: {")) {
+		return false;
+	}
+
+	if (!consume("}")) {
+		do {
+			std::string_view field;
+			int64_t coefficient;
+			int8_t exponent;
+			int index;
+
+			if (!name(field) || !consume(": ") || !decimal(coefficient, exponent)) {
+				return false;
+			}
+
+			index = Reading::field(field);
+			if (index >= 0) {
+				reading.setValue(index, coefficient, exponent);
+			}
+		} while (consume(","));
+
+		if (!consume("}")) {
+			return false;
+		}
+	}
+
+	if (!consume("}")) {
+		return false;
+	}
+
+	whitespace();
+	if (consume("timestamp: ")) {
+		if (!timestamp(reading.timestamp)) {
+			return false;
+		}
+		whitespace();
+	}
+
+	if (consume("---")) {
+		whitespace();
+	} else if (!text_.empty()) {
+		return false;
+	}
+
+	return true;
+}
+
+bool ReadingParser::consume(std::string_view literal) {
+	if (text_.substr(0, literal.length()) == literal) {
+		text_.remove_prefix(literal.length());
+		return true;
+	}
+
+	return false;
+}
+
+bool ReadingParser::string(std::string_view &value) {
+	if (!consume("\"")) {
+		return false;
+	}
+
+	size_t end = text_.find('"');
+	if (end == std::string_view::npos) {
+		return false;
+	}
+
+	value = text_.substr(0, end);
+	if (value.find('\\') != std::string_view::npos) {
+		return false;
+	}
+
+	text_.remove_prefix(end + 1);
+	return true;
+}
+
+bool ReadingParser::name(std::string_view &value) {
+	size_t length = 0;
+
+	while (length < text_.length()
+			&& ((text_[length] >= 'a' && text_[length] <= 'z')
+				|| (text_[length] >= 'A' && text_[length] <= 'Z'))) {
+		length++;
+	}
+
+	if (length == 0) {
+		return false;
+	}
+
+	value = text_.substr(0, length);
+	text_.remove_prefix(length);
+	return true;
+}
+
+static bool digits(std::string_view &text, uint64_t &value, size_t &count, size_t limit) {
+	count = 0;
+	value = 0;
+
+	while (!text.empty() && text[0] >= '0' && text[0] <= '9') {
+		if (count >= limit) {
+			return false;
+		}
+
+		value = value * 10 + (text[0] - '0');
+		count++;
+		text.remove_prefix(1);
+	}
+
+	return count > 0;
+}
+
+bool ReadingParser::integer(uint8_t &value) {
+	uint64_t number;
+	size_t count;
+
+	if (!digits(text_, number, count, 3) || number > UINT8_MAX) {
+		return false;
+	}
+
+	value = number;
+	return true;
+}
+
+bool ReadingParser::decimal(int64_t &coefficient, int8_t &exponent) {
+	constexpr size_t MAX_DIGITS = 10;
+	bool negative = consume("-");
+	uint64_t value;
+	uint64_t fraction;
+	size_t count;
+	size_t fractionDigits;
+	int64_t power = 0;
+
+	if (!digits(text_, value, count, MAX_DIGITS)) {
+		return false;
+	}
+
+	if (consume(".")) {
+		if (!digits(text_, fraction, fractionDigits, MAX_DIGITS)) {
+			return false;
+		}
+
+		// Only a zero fraction (as output by Decimal::printTo()) is expected
+		if (fraction != 0) {
+			return false;
+		}
+	}
+
+	if (consume("e")) {
+		bool negativeExponent = consume("-");
+		uint64_t magnitude;
+
+		if (!digits(text_, magnitude, count, 3)) {
+			return false;
+		}
+
+		power = negativeExponent ? -(int64_t)magnitude : (int64_t)magnitude;
+	}
+
+	if (power < INT8_MIN || power > INT8_MAX) {
+		return false;
+	}
+
+	if (negative ? value > (uint64_t)INT32_MAX + 1 : value > UINT32_MAX) {
+		return false;
+	}
+
+	coefficient = negative ? -(int64_t)value : (int64_t)value;
+	exponent = power;
+	return true;
+}
+
+bool ReadingParser::timestamp(uint64_t &value) {
+	constexpr size_t MICROSECOND_DIGITS = 6;
+	uint64_t seconds;
+	uint64_t fraction = 0;
+	size_t count;
+	size_t fractionDigits = 0;
+
+	if (!digits(text_, seconds, count, 12)) {
+		return false;
+	}
+
+	if (consume(".")) {
+		if (!digits(text_, fraction, fractionDigits, MICROSECOND_DIGITS)) {
+			return false;
+		}
+	}
+
+	for (; fractionDigits < MICROSECOND_DIGITS; fractionDigits++) {
+		fraction *= 10;
+	}
+
+	value = seconds * 1000000 + fraction;
+	return true;
+}
+
+void ReadingParser::whitespace() {
+	while (!text_.empty() && (text_[0] == ' ' || text_[0] == '\r' || text_[0] == '\n')) {
+		text_.remove_prefix(1);
+	}
+}
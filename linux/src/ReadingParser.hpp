@@ -0,0 +1,54 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_READINGPARSER_HPP
+#define POWER_METER_READINGPARSER_HPP
+
+#include <string_view>
+
+#include "Reading.hpp"
+
+/**
+Parser for the flow-style YAML that PowerMeter::printTo() outputs:
+	meter: {model: "…"[,serialNumber: "…"][,bus: n,address: n],reading: {name: value[,name: value]…}}
+optionally followed by a line with "timestamp: seconds[.fraction]". Multiple
+documents are separated by a "---" line.
+
+Values are "coefficient.0[eExponent]". Anything else is rejected rather
+than interpreted as general YAML.
+*/
+class ReadingParser {
+public:
+	explicit ReadingParser(std::string_view text);
+	bool finished() const;
+	/** Parse the next document */
+	bool next(Reading &reading);
+
+private:
+	bool consume(std::string_view literal);
+	bool string(std::string_view &value);
+	bool name(std::string_view &value);
+	bool integer(uint8_t &value);
+	bool decimal(int64_t &coefficient, int8_t &exponent);
+	bool timestamp(uint64_t &value);
+	void whitespace();
+
+	std::string_view text_;
+};
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SerialPort.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <termios.h>
+#include <unistd.h>
+
+static speed_t baudRateSpeed(unsigned long baudRate) {
+	switch (baudRate) {
+	case 1200: return B1200;
+	case 2400: return B2400;
+	case 4800: return B4800;
+	case 9600: return B9600;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	case 115200: return B115200;
+	default: return B0;
+	}
+}
+
+SerialPort::SerialPort() {
+
+}
+
+SerialPort::~SerialPort() {
+	close();
+}
+
+bool SerialPort::open(const std::string &device, unsigned long baudRate) {
+	speed_t speed = baudRateSpeed(baudRate);
+	struct termios tio;
+
+	close();
+	device_ = device;
+
+	if (speed == B0) {
+		fprintf(stderr, "%s: unsupported baud rate %lu\n", device_.c_str(), baudRate);
+		return false;
+	}
+
+	fd_ = ::open(device_.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (fd_ < 0) {
+		perror(device_.c_str());
+		return false;
+	}
+
+	if (tcgetattr(fd_, &tio)) {
+		perror(device_.c_str());
+		close();
+		return false;
+	}
+
+	cfmakeraw(&tio);
+	tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+
+	if (tcsetattr(fd_, TCSANOW, &tio) || tcflush(fd_, TCIOFLUSH)) {
+		perror(device_.c_str());
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void SerialPort::close() {
+	if (fd_ != -1) {
+		::close(fd_);
+		fd_ = -1;
+	}
+
+	start_ = end_ = 0;
+}
+
+bool SerialPort::fill(int timeout) {
+	struct pollfd pfd{fd_, POLLIN, 0};
+	ssize_t len;
+
+	if (start_ < end_) {
+		return true;
+	}
+
+	if (fd_ == -1) {
+		return false;
+	}
+
+	if (timeout > 0 && poll(&pfd, 1, timeout) <= 0) {
+		return false;
+	}
+
+	len = ::read(fd_, buffer_, sizeof(buffer_));
+	if (len < 0 && errno != EAGAIN && errno != EINTR) {
+		perror(device_.c_str());
+	}
+	if (len <= 0) {
+		return false;
+	}
+
+	start_ = 0;
+	end_ = len;
+	return true;
+}
+
+int SerialPort::available() {
+	if (!fill(POLL_MILLIS)) {
+		return 0;
+	}
+
+	return end_ - start_;
+}
+
+int SerialPort::read() {
+	if (!fill(0)) {
+		return -1;
+	}
+
+	return buffer_[start_++];
+}
+
+int SerialPort::peek() {
+	if (!fill(0)) {
+		return -1;
+	}
+
+	return buffer_[start_];
+}
+
+size_t SerialPort::write(uint8_t c) {
+	return write(&c, 1);
+}
+
+size_t SerialPort::write(const uint8_t *buffer, size_t size) {
+	size_t n = 0;
+
+	while (fd_ != -1 && n < size) {
+		ssize_t len = ::write(fd_, buffer + n, size - n);
+
+		if (len < 0) {
+			if (errno == EAGAIN) {
+				struct pollfd pfd{fd_, POLLOUT, 0};
+
+				poll(&pfd, 1, -1);
+			} else if (errno != EINTR) {
+				perror(device_.c_str());
+				break;
+			}
+		} else {
+			n += len;
+		}
+	}
+
+	return n;
+}
+
+void SerialPort::flush() {
+	if (fd_ != -1) {
+		tcdrain(fd_);
+	}
+}
@@ -0,0 +1,66 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_SERIALPORT_HPP
+#define POWER_METER_SERIALPORT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+#include <string>
+
+/**
+RS485 adapter (or any other tty) as a Stream for ModbusMaster.
+
+The port is raw 8N1 with no flow control. USB adapters switch the
+transceiver direction themselves, so there's nothing to do before and
+after transmitting other than wait for the output to drain.
+
+ModbusMaster polls available() until the response arrives, so when
+nothing has been received it waits up to POLL_MILLIS for data instead of
+returning immediately and being called again in a busy loop.
+*/
+class SerialPort final: public Stream {
+public:
+	SerialPort();
+	~SerialPort() override;
+	bool open(const std::string &device, unsigned long baudRate);
+	void close();
+
+	int available() override;
+	int read() override;
+	int peek() override;
+	size_t write(uint8_t c) override;
+	size_t write(const uint8_t *buffer, size_t size) override;
+	using Print::write;
+	void flush() override;
+
+	static constexpr int POLL_MILLIS = 1;
+
+private:
+	bool fill(int timeout);
+
+	std::string device_;
+	int fd_ = -1;
+	uint8_t buffer_[256];
+	size_t start_ = 0;
+	size_t end_ = 0;
+};
+
+#endif
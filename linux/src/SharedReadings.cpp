@@ -0,0 +1,200 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SharedReadings.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <new>
+#include <thread>
+
+static_assert(sizeof(SharedReadings::Header) <= SharedReadings::HEADER_SIZE, "Header too large");
+static_assert(sizeof(SharedReadings::Entry) == SharedReadings::ENTRY_SIZE, "Entry size mismatch");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Atomic values must be lock free to be shared");
+
+SharedReadings::SharedReadings() {
+
+}
+
+SharedReadings::~SharedReadings() {
+	close();
+}
+
+bool SharedReadings::open(const std::string &name, uint32_t slots) {
+	size_t size = HEADER_SIZE + ((size_t)slots + RING_SIZE) * ENTRY_SIZE;
+	int fd;
+
+	// Replace any existing region, so that readers of a previous instance
+	// that haven't noticed it has gone can't be affected by resizing it
+	shm_unlink(name.c_str());
+
+	fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		perror(name.c_str());
+		return false;
+	}
+
+	if (ftruncate(fd, size)) {
+		perror("ftruncate");
+		::close(fd);
+		shm_unlink(name.c_str());
+		return false;
+	}
+
+	map_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map_ == MAP_FAILED) {
+		perror("mmap");
+		map_ = nullptr;
+		shm_unlink(name.c_str());
+		return false;
+	}
+	name_ = name;
+	size_ = size;
+	slotCount_ = slots;
+	timestamps_ = std::make_unique<uint64_t[]>(slots);
+
+	// The region is zero-filled, so the atomic values are already valid
+	header_ = new (map_) Header;
+	slots_ = reinterpret_cast<Entry *>((uint8_t *)map_ + HEADER_SIZE);
+	ring_ = slots_ + slots;
+
+	header_->headerSize = HEADER_SIZE;
+	header_->entrySize = ENTRY_SIZE;
+	header_->slots = slots;
+	header_->ringSize = RING_SIZE;
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+	return true;
+}
+
+void SharedReadings::close() {
+	if (map_) {
+		munmap(map_, size_);
+		map_ = nullptr;
+		header_ = nullptr;
+		shm_unlink(name_.c_str());
+	}
+}
+
+void SharedReadings::write(Entry &entry, uint64_t sequence, const uint8_t *data, size_t length) {
+	entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	entry.length = length;
+	memcpy(entry.data, data, length);
+	entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void SharedReadings::update(uint32_t slot, uint64_t timestamp, const uint8_t *data, size_t length) {
+	Entry &entry = slots_[slot];
+	uint64_t sequence = entry.sequence.load(std::memory_order_relaxed);
+
+	// Wait for any other thread writing a reading from the same meter
+	while (true) {
+		if (sequence % 2) {
+			std::this_thread::yield();
+			sequence = entry.sequence.load(std::memory_order_relaxed);
+		} else if (entry.sequence.compare_exchange_weak(sequence, sequence + 1,
+				std::memory_order_acquire, std::memory_order_relaxed)) {
+			break;
+		}
+	}
+
+	if (timestamp < timestamps_[slot]) {
+		// The other thread wrote a later reading, so leave the entry unchanged
+		entry.sequence.store(sequence, std::memory_order_release);
+		return;
+	}
+	timestamps_[slot] = timestamp;
+
+	std::atomic_thread_fence(std::memory_order_release);
+	entry.length = length;
+	memcpy(entry.data, data, length);
+	entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void SharedReadings::updateSlot(std::string_view serialNumber, uint64_t timestamp, const uint8_t *data, size_t length) {
+	{
+		std::shared_lock lock{mutex_};
+		auto slot = meters_.find(serialNumber);
+
+		if (slot != meters_.end()) {
+			update(slot->second, timestamp, data, length);
+			return;
+		}
+	}
+
+	std::unique_lock lock{mutex_};
+	auto slot = meters_.find(serialNumber);
+
+	if (slot != meters_.end()) {
+		update(slot->second, timestamp, data, length);
+		return;
+	}
+
+	uint32_t meters = header_->meters.load(std::memory_order_relaxed);
+
+	if (meters >= slotCount_) {
+		if (overflows_++ == 0) {
+			fprintf(stderr, "Shared memory has no slot for meter \"%.*s\" (all %u are in use)\n",
+				(int)serialNumber.length(), serialNumber.data(), slotCount_);
+		}
+		return;
+	}
+
+	meters_.emplace(serialNumber, meters);
+	timestamps_[meters] = timestamp;
+	write(slots_[meters], 0, data, length);
+	header_->meters.store(meters + 1, std::memory_order_release);
+}
+
+void SharedReadings::publish(std::string_view serialNumber, uint64_t timestamp, const uint8_t *data, size_t length) {
+	if (!header_) {
+		return;
+	}
+
+	if (length > sizeof(Entry::data)) {
+		dropped_++;
+		return;
+	}
+
+	updateSlot(serialNumber, timestamp, data, length);
+
+	uint64_t head = next_.fetch_add(1, std::memory_order_relaxed);
+
+	write(ring_[head % RING_SIZE], head * 2, data, length);
+
+	// Publish entries in order, after any reserved earlier have been written
+	while (header_->head.load(std::memory_order_acquire) != head) {
+		std::this_thread::yield();
+	}
+	header_->head.store(head + 1, std::memory_order_release);
+}
+
+uint64_t SharedReadings::dropped() const {
+	return dropped_;
+}
+
+uint64_t SharedReadings::overflows() const {
+	return overflows_;
+}
@@ -0,0 +1,114 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_SHAREDREADINGS_HPP
+#define POWER_METER_SHAREDREADINGS_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+/**
+Shared memory region (under /dev/shm) with the latest reading from each
+meter and a ring of recent readings, for local clients to read without
+any system calls.
+
+Each entry contains a message in the same format as the LocalServer (the
+4-byte IPv4 address of the sender followed by a binary datagram) and is
+protected by a sequence number. The sequence number is odd while the
+entry is being written, so readers copy the entry and then check that
+the sequence number is even and hasn't changed.
+
+Ring entry N (of all entries ever written) is at position N % RING_SIZE
+and has the sequence number 2N + 2 once it has been written. The head is
+the number of entries written, and is updated after each entry. Writers
+reserve ring entries without a lock and advance the head in order.
+
+Meters are given a slot for their latest reading on their first reading
+(the only time a lock is held exclusively). If two threads write readings
+from the same meter at the same time, the reading with the later
+timestamp is kept. Readings from meters after
+the slots are full are only written to the ring, and counted as
+overflows.
+
+Readers must not write to the region. All values are little-endian.
+*/
+class SharedReadings {
+public:
+	SharedReadings();
+	~SharedReadings();
+	bool open(const std::string &name, uint32_t slots = DEFAULT_SLOTS);
+	void close();
+	void publish(std::string_view serialNumber, uint64_t timestamp, const uint8_t *data, size_t length);
+	uint64_t dropped() const;
+	uint64_t overflows() const;
+
+	static constexpr const char *DEFAULT_NAME = "/power-meter-collector";
+	static constexpr char MAGIC[8] = {'P', 'M', 'S', 'H', 'M', 'E', 'M', '1'};
+	static constexpr uint32_t DEFAULT_SLOTS = 1024;
+	static constexpr uint32_t RING_SIZE = 4096;
+	static constexpr size_t ENTRY_SIZE = 256;
+
+	struct Header {
+		char magic[8];
+		uint32_t headerSize;
+		uint32_t entrySize;
+		uint32_t slots;
+		uint32_t ringSize;
+		std::atomic<uint32_t> meters; ///< Slots in use
+		uint32_t reserved;
+		std::atomic<uint64_t> head; ///< Ring entries written
+	};
+
+	struct Entry {
+		std::atomic<uint64_t> sequence;
+		uint32_t length;
+		uint32_t reserved;
+		uint8_t data[ENTRY_SIZE - 16];
+	};
+
+	static constexpr size_t HEADER_SIZE = 64;
+
+private:
+	void updateSlot(std::string_view serialNumber, uint64_t timestamp, const uint8_t *data, size_t length);
+	void update(uint32_t slot, uint64_t timestamp, const uint8_t *data, size_t length);
+	static void write(Entry &entry, uint64_t sequence, const uint8_t *data, size_t length);
+
+	std::string name_;
+	void *map_ = nullptr;
+	size_t size_ = 0;
+	uint32_t slotCount_ = 0;
+	Header *header_ = nullptr;
+	Entry *slots_ = nullptr;
+	Entry *ring_ = nullptr;
+	std::shared_mutex mutex_; ///< Exclusive to allocate slots
+	std::map<std::string, uint32_t, std::less<>> meters_;
+	std::unique_ptr<uint64_t[]> timestamps_; ///< Of each slot's reading, only accessed while writing it
+	std::atomic<uint64_t> next_{0}; ///< Ring entries reserved
+	std::atomic<uint64_t> dropped_{0};
+	std::atomic<uint64_t> overflows_{0};
+};
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include "Collector.hpp"
+#include "LocalServer.hpp"
+#include "Notify.hpp"
+#include "SharedReadings.hpp"
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-t THREADS] [-s SOCKET] [-m NAME] [-M METERS] [-i SECONDS] [-v]\n", name);
+	fprintf(stderr, "  -t THREADS  number of receive threads (default 1)\n");
+	fprintf(stderr, "  -s SOCKET   local socket to publish readings on (default %s)\n", LocalServer::DEFAULT_PATH);
+	fprintf(stderr, "  -m NAME     shared memory to publish readings in (default %s)\n", SharedReadings::DEFAULT_NAME);
+	fprintf(stderr, "  -M METERS   meters with a latest reading in shared memory (default %u)\n", SharedReadings::DEFAULT_SLOTS);
+	fprintf(stderr, "  -i SECONDS  statistics interval (default 10)\n");
+	fprintf(stderr, "  -v          log statistics to stderr\n");
+}
+
+int main(int argc, char *argv[]) {
+	std::string path = LocalServer::DEFAULT_PATH;
+	std::string name = SharedReadings::DEFAULT_NAME;
+	unsigned int threads = 1;
+	unsigned int meters = SharedReadings::DEFAULT_SLOTS;
+	unsigned int interval = 10;
+	bool verbose = false;
+	sigset_t signals;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:s:m:M:i:vh")) != -1) {
+		switch (opt) {
+		case 't':
+			threads = strtoul(optarg, nullptr, 10);
+			if (threads == 0) {
+				threads = std::thread::hardware_concurrency();
+			}
+			break;
+
+		case 's':
+			path = optarg;
+			break;
+
+		case 'm':
+			name = optarg;
+			break;
+
+		case 'M':
+		{
+			char *end = nullptr;
+
+			meters = strtoul(optarg, &end, 10);
+			if (end == optarg || *end != '\0' || meters == 0) {
+				fprintf(stderr, "Invalid number of meters: %s\n", optarg);
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		}
+
+		case 'i':
+			interval = strtoul(optarg, nullptr, 10);
+			if (interval == 0) {
+				interval = 1;
+			}
+			break;
+
+		case 'v':
+			verbose = true;
+			break;
+
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	// Handle signals synchronously in the main thread
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigaddset(&signals, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+	LocalServer server;
+	if (!server.open(path)) {
+		return EXIT_FAILURE;
+	}
+
+	SharedReadings shared;
+	if (!shared.open(name, meters)) {
+		return EXIT_FAILURE;
+	}
+
+	Collector collector{server, shared, threads};
+	if (!collector.start()) {
+		return EXIT_FAILURE;
+	}
+
+	notify("READY=1");
+
+	while (true) {
+		struct timespec timeout{(time_t)interval, 0};
+		int sig = sigtimedwait(&signals, nullptr, &timeout);
+
+		if (sig == SIGINT || sig == SIGTERM) {
+			break;
+		}
+
+		Collector::Statistics stats = collector.statistics();
+		char status[512];
+
+		snprintf(status, sizeof(status),
+			"%llu datagrams, %llu readings, %llu invalid, %llu kernel drops, %zu clients, %llu client drops, %llu shared drops, %llu shared overflows",
+			(unsigned long long)stats.datagrams, (unsigned long long)stats.readings,
+			(unsigned long long)stats.invalid, (unsigned long long)stats.kernelDrops,
+			server.clients(), (unsigned long long)server.dropped(), (unsigned long long)shared.dropped(),
+			(unsigned long long)shared.overflows());
+
+		notify(std::string{"STATUS="} + status);
+		if (verbose) {
+			fprintf(stderr, "%s\n", status);
+		}
+	}
+
+	notify("STOPPING=1");
+	collector.stop();
+	server.stop();
+	shared.close();
+	return EXIT_SUCCESS;
+}
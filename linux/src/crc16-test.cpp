@@ -0,0 +1,191 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "CRC16.hpp"
+
+/// Modbus RTU frames in the format used by each meter, including the CRC
+struct Frame {
+	const char *name;
+	std::vector<uint8_t> data;
+};
+
+static const Frame FRAMES[] = {
+	{ "RI-D19-80-C read serial number", { 0x01, 0x03, 0x00, 0x27, 0x00, 0x03, 0xB5, 0xC0 } },
+	{ "RI-D19-80-C serial number", { 0x01, 0x03, 0x06, 0x00, 0x00, 0x12, 0x34, 0x56, 0x78, 0x5A, 0x41 } },
+	{ "RI-D19-80-C read measurements", { 0x01, 0x03, 0x00, 0x00, 0x00, 0x07, 0x04, 0x08 } },
+	{ "RI-D19-80-C measurements", { 0x01, 0x03, 0x0E, 0x09, 0xA7, 0x00, 0x03, 0x01, 0xF4, 0x00, 0x51, 0x00, 0x1C, 0x00, 0x5A, 0x03, 0xE8, 0xB4, 0x15 } },
+	{ "RI-D19-80-C password", { 0x01, 0x28, 0xFE, 0x01, 0x00, 0x02, 0x04, 0x00, 0x00, 0x00, 0x00, 0xFB, 0x12 } },
+	{ "RI-D19-80-C password success", { 0x01, 0x28, 0xFE, 0x01, 0x00, 0x01, 0xC0, 0x24 } },
+	{ "RI-D19-80-C password failure", { 0x01, 0xA8, 0xFE, 0x01, 0x00, 0x59, 0xC0 } },
+	{ "PZEM-004T-100A read measurements", { 0x01, 0x04, 0x00, 0x00, 0x00, 0x0A, 0x70, 0x0D } },
+	{ "PZEM-004T-100A measurements", { 0x01, 0x04, 0x14, 0x09, 0xA7, 0x0B, 0xB8, 0x00, 0x00, 0x02, 0xD5, 0x00, 0x00, 0x00, 0x58, 0x00, 0x00, 0x01, 0xF4, 0x00, 0x64, 0x00, 0x00, 0x84, 0x39 } },
+	{ "PZEM-004T-100A reset energy", { 0x01, 0x42, 0x80, 0x11 } },
+};
+
+typedef uint16_t (*UpdateFunction)(uint16_t crc, uint8_t data);
+
+static const struct {
+	const char *name;
+	UpdateFunction update;
+} IMPLEMENTATIONS[] = {
+	{ "bitwise", CRC16::updateBitwise },
+	{ "nibble", CRC16::updateNibble },
+	{ "table", CRC16::updateTable },
+};
+
+static uint16_t calculate(UpdateFunction update, const uint8_t *data, size_t length) {
+	uint16_t crc = CRC16::INITIAL;
+
+	while (length--) {
+		crc = update(crc, *data++);
+	}
+	return crc;
+}
+
+static bool conformance() {
+	bool ok = true;
+
+	for (const auto &frame : FRAMES) {
+		size_t length = frame.data.size() - 2;
+		uint16_t expected = frame.data[length] | (frame.data[length + 1] << 8);
+
+		for (const auto &impl : IMPLEMENTATIONS) {
+			uint16_t crc = calculate(impl.update, frame.data.data(), length);
+
+			if (crc != expected) {
+				printf("FAIL %s: %s CRC %04X != %04X\n", frame.name, impl.name, crc, expected);
+				ok = false;
+			}
+		}
+
+		CRC16 crc;
+
+		for (uint8_t value : frame.data) {
+			crc.update(value);
+		}
+
+		if (!crc.valid()) {
+			printf("FAIL %s: incremental CRC residue %04X\n", frame.name, crc.value());
+			ok = false;
+		}
+
+		crc.reset();
+		crc.update(frame.data.data(), length);
+		if (crc.value() != expected) {
+			printf("FAIL %s: block CRC %04X != %04X\n", frame.name, crc.value(), expected);
+			ok = false;
+		}
+
+		std::vector<uint8_t> corrupt = frame.data;
+
+		corrupt[length / 2] ^= 0x01;
+		crc.reset();
+		crc.update(corrupt.data(), corrupt.size());
+		if (crc.valid()) {
+			printf("FAIL %s: corrupt frame accepted\n", frame.name);
+			ok = false;
+		}
+	}
+
+	for (unsigned int crc = 0; crc <= 0xFFFF; crc += 0xFF) {
+		for (unsigned int value = 0; value <= 0xFF; value++) {
+			uint16_t expected = CRC16::updateBitwise(crc, value);
+
+			for (const auto &impl : IMPLEMENTATIONS) {
+				if (impl.update(crc, value) != expected) {
+					printf("FAIL %s update(%04X, %02X)\n", impl.name, crc, value);
+					return false;
+				}
+			}
+		}
+	}
+
+	printf("%s: %zu frames\n", ok ? "PASS" : "FAIL", sizeof(FRAMES) / sizeof(FRAMES[0]));
+	return ok;
+}
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void benchmark(unsigned long bytes) {
+	std::vector<uint8_t> data;
+
+	for (const auto &frame : FRAMES) {
+		data.insert(data.end(), frame.data.begin(), frame.data.end());
+	}
+
+	for (const auto &impl : IMPLEMENTATIONS) {
+		unsigned long iterations = bytes / data.size() + 1;
+		volatile uint16_t result = 0;
+		double start = now();
+
+		for (unsigned long i = 0; i < iterations; i++) {
+			result = result + calculate(impl.update, data.data(), data.size());
+		}
+
+		double elapsed = now() - start;
+
+		printf("%-8s %8.3f ns/byte %10.1f MB/s\n", impl.name,
+			elapsed * 1e9 / (iterations * data.size()),
+			iterations * data.size() / elapsed / 1e6);
+	}
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-b BYTES]\n", name);
+	fprintf(stderr, "  -b BYTES  benchmark each implementation over this many bytes of frames\n");
+}
+
+int main(int argc, char *argv[]) {
+	unsigned long bytes = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:h")) != -1) {
+		switch (opt) {
+		case 'b':
+			bytes = strtoul(optarg, nullptr, 10);
+			break;
+
+		case 'h':
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if (!conformance()) {
+		return EXIT_FAILURE;
+	}
+
+	if (bytes) {
+		benchmark(bytes);
+	}
+	return EXIT_SUCCESS;
+}
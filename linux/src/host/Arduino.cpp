@@ -0,0 +1,157 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <time.h>
+
+HardwareSerial Serial;
+
+static uint64_t monotonicMicros() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * These wrap at 2³² like they do on the Arduino, so that the drivers are
+ * run with the same arithmetic.
+ */
+unsigned long millis() {
+	return (uint32_t)(monotonicMicros() / 1000);
+}
+
+unsigned long micros() {
+	return (uint32_t)monotonicMicros();
+}
+
+void delay(unsigned long ms) {
+	struct timespec ts{(time_t)(ms / 1000), (long)(ms % 1000) * 1000000};
+
+	while (nanosleep(&ts, &ts) == -1);
+}
+
+void delayMicroseconds(unsigned int us) {
+	struct timespec ts{(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+
+	while (nanosleep(&ts, &ts) == -1);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+	size_t n = 0;
+
+	while (size-- > 0) {
+		if (write(*buffer++)) {
+			n++;
+		} else {
+			break;
+		}
+	}
+
+	return n;
+}
+
+size_t Print::print(const __FlashStringHelper *value) {
+	return write(reinterpret_cast<const char *>(value));
+}
+
+size_t Print::print(const String &value) {
+	return write(value.c_str(), value.length());
+}
+
+size_t Print::print(const char *value) {
+	return write(value);
+}
+
+size_t Print::print(char value) {
+	return write((uint8_t)value);
+}
+
+size_t Print::print(unsigned char value, int base) {
+	return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base) {
+	return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+	return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+	if (base == 10 && value < 0) {
+		size_t n = print('-');
+
+		return n + printNumber(-(unsigned long)value, 10);
+	}
+
+	return printNumber((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+	return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits) {
+	char buffer[64];
+
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+	return write(buffer);
+}
+
+size_t Print::print(const Printable &value) {
+	return value.printTo(*this);
+}
+
+size_t Print::println() {
+	return write("\r\n");
+}
+
+size_t Print::printNumber(unsigned long value, int base) {
+	char buffer[8 * sizeof(value) + 1];
+	char *str = &buffer[sizeof(buffer) - 1];
+
+	if (base < 2) {
+		base = 10;
+	}
+
+	*str = '\0';
+	do {
+		char c = value % base;
+
+		value /= base;
+		*--str = c < 10 ? c + '0' : c + 'A' - 10;
+	} while (value);
+
+	return write(str);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+	return fputc(c, stderr) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+	return fwrite(buffer, 1, size, stderr);
+}
+
+void HardwareSerial::flush() {
+	fflush(stderr);
+}
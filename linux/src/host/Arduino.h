@@ -0,0 +1,175 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POWER_METER_ARDUINO_H
+#define POWER_METER_ARDUINO_H
+
+/*
+ * The subset of the Arduino API used by the meter drivers and ModbusMaster,
+ * so that they can be built for Linux (POWER_METER_HOST).
+ *
+ * There's no flash, so PROGMEM data is ordinary memory. ARDUINO isn't
+ * defined because this isn't an Arduino board.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(const void * const *)(addr))
+#define strlen_P strlen
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(PSTR(string_literal)))
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define lowByte(w) ((uint8_t)((w) & 0xFF))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define bit(b) (1UL << (b))
+
+using std::min;
+using std::max;
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+static inline uint16_t makeWord(uint8_t h, uint8_t l) { return ((uint16_t)h << 8) | l; }
+#define word(...) makeWord(__VA_ARGS__)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+static inline void yield() {}
+
+static inline void pinMode(uint8_t, uint8_t) {}
+static inline void digitalWrite(uint8_t, uint8_t) {}
+static inline int digitalRead(uint8_t) { return LOW; }
+static inline void noInterrupts() {}
+static inline void interrupts() {}
+
+class String {
+public:
+	String(const char *value = "") : value_(value) {}
+	String(const String &value) = default;
+	String &operator=(const String &value) = default;
+	String &operator=(const char *value) { value_ = value; return *this; }
+	String &operator+=(const String &value) { value_ += value.value_; return *this; }
+	String &operator+=(const char *value) { value_ += value; return *this; }
+	String &operator+=(char value) { value_ += value; return *this; }
+	bool operator==(const String &value) const { return value_ == value.value_; }
+	bool operator==(const char *value) const { return value_ == value; }
+	bool operator!=(const String &value) const { return value_ != value.value_; }
+	bool operator!=(const char *value) const { return value_ != value; }
+	char operator[](unsigned int index) const { return index < value_.length() ? value_[index] : 0; }
+	unsigned int length() const { return value_.length(); }
+	const char *c_str() const { return value_.c_str(); }
+
+private:
+	std::string value_;
+};
+
+class Print;
+
+class Printable {
+public:
+	virtual ~Printable() {}
+	virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print {
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	size_t write(const char *str) { return str == nullptr ? 0 : write((const uint8_t *)str, strlen(str)); }
+	size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+	virtual void flush() {}
+
+	size_t print(const __FlashStringHelper *value);
+	size_t print(const String &value);
+	size_t print(const char *value);
+	size_t print(char value);
+	size_t print(unsigned char value, int base = DEC);
+	size_t print(int value, int base = DEC);
+	size_t print(unsigned int value, int base = DEC);
+	size_t print(long value, int base = DEC);
+	size_t print(unsigned long value, int base = DEC);
+	size_t print(double value, int digits = 2);
+	size_t print(const Printable &value);
+
+	size_t println();
+	template <class T>
+	size_t println(const T &value) { size_t n = print(value); return n + println(); }
+	template <class T>
+	size_t println(const T &value, int format) { size_t n = print(value, format); return n + println(); }
+
+private:
+	size_t printNumber(unsigned long value, int base);
+};
+
+class Stream: public Print {
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+};
+
+/// Diagnostic output, written to stderr
+class HardwareSerial final: public Stream {
+public:
+	void begin(unsigned long) {}
+	int available() override { return 0; }
+	int read() override { return -1; }
+	int peek() override { return -1; }
+	size_t write(uint8_t c) override;
+	size_t write(const uint8_t *buffer, size_t size) override;
+	using Print::write;
+	void flush() override;
+	operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
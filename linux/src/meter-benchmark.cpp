@@ -0,0 +1,203 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <deque>
+
+#include <ModbusMaster.h>
+
+#include "CRC16.hpp"
+#include "OutputFormat.hpp"
+#include "PZEM_004T_100A.hpp"
+#include "PowerMeter.hpp"
+#include "RI_D19_80_C.hpp"
+#include "StaticMeter.hpp"
+
+/**
+Meter that responds to register reads immediately, so that the time
+taken is the firmware's read, decode and output path without a bus.
+*/
+class LoopbackMeter final: public Stream {
+public:
+	int available() override {
+		return response_.size();
+	}
+
+	int read() override {
+		if (response_.empty()) {
+			return -1;
+		}
+
+		int data = response_.front();
+		response_.pop_front();
+		return data;
+	}
+
+	int peek() override {
+		return response_.empty() ? -1 : response_.front();
+	}
+
+	size_t write(uint8_t data) override {
+		request_[length_++] = data;
+		if (length_ == sizeof(request_)) {
+			respond();
+			length_ = 0;
+		}
+		return 1;
+	}
+
+private:
+	void respond() {
+		uint16_t start = (request_[2] << 8) | request_[3];
+		uint16_t count = (request_[4] << 8) | request_[5];
+		CRC16 crc;
+
+		response_.clear();
+		response_.push_back(request_[0]);
+		response_.push_back(request_[1]);
+		response_.push_back(count * 2);
+		for (uint16_t i = 0; i < count; i++) {
+			uint16_t value = registerValue(start + i);
+
+			response_.push_back(value >> 8);
+			response_.push_back(value & 0xFF);
+		}
+
+		for (uint8_t data : response_) {
+			crc.update(data);
+		}
+		response_.push_back(crc.value() & 0xFF);
+		response_.push_back(crc.value() >> 8);
+	}
+
+	/// Plausible values for both meters (240.0V, 50.0Hz, low power)
+	static uint16_t registerValue(uint16_t address) {
+		switch (address) {
+		case 0x0000: return 2400;
+		case 0x0002: return 500;
+		case 0x0004: return 0;
+		case 0x0007: return 500;
+		default: return (address * 7) & 0xFF;
+		}
+	}
+
+	uint8_t request_[8]; ///< Read registers request
+	size_t length_ = 0;
+	std::deque<uint8_t> response_;
+};
+
+/// Output that discards everything
+class NullOutput final: public Print {
+public:
+	size_t write(uint8_t data) override {
+		total_ += data;
+		return 1;
+	}
+
+private:
+	volatile uint8_t total_ = 0;
+};
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Read and output the meter repeatedly, returning the time taken for each
+ * reading (ns). The meter and output are used through the types they're
+ * passed as, like Main.cpp does in each build mode.
+ */
+template <class Format, class Meter, class Output>
+static double run(Meter &meter, Output &output, unsigned long iterations) {
+	unsigned long failures = 0;
+	double start = now();
+
+	for (unsigned long i = 0; i < iterations; i++) {
+		if (!meter.read()) {
+			failures++;
+		}
+		Format::write(meter, output, i);
+	}
+
+	double elapsed = now() - start;
+
+	if (failures == iterations) {
+		fprintf(stderr, "All reads failed\n");
+	}
+	return elapsed * 1e9 / iterations;
+}
+
+template <class Driver>
+static void compare(const char *name, unsigned long iterations) {
+	LoopbackMeter bus;
+	ModbusMaster modbus;
+	NullOutput output;
+
+	// Virtual: the meter through PowerMeter and the output through Print
+	Driver driver{modbus, &bus, 0x01};
+	PowerMeter &virtualMeter = driver;
+	Print &virtualOutput = output;
+
+	// Static: the final types, with the driver bound at compile time
+	StaticMeter<Driver> staticMeter{modbus, &bus, 0x01};
+
+	printf("%-16s %-6s %10.1f %10.1f\n", name, "text",
+		run<TextFormat>(virtualMeter, virtualOutput, iterations),
+		run<TextFormat>(staticMeter, output, iterations));
+	printf("%-16s %-6s %10.1f %10.1f\n", name, "binary",
+		run<BinaryFormat>(virtualMeter, virtualOutput, iterations),
+		run<BinaryFormat>(staticMeter, output, iterations));
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-n ITERATIONS]\n", name);
+	fprintf(stderr, "  -n ITERATIONS  readings for each meter, format and build mode (default 100000)\n");
+}
+
+int main(int argc, char *argv[]) {
+	unsigned long iterations = 100000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			iterations = strtoul(optarg, nullptr, 10);
+			if (iterations == 0) {
+				iterations = 1;
+			}
+			break;
+
+		case 'h':
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	printf("%-16s %-6s %10s %10s  (ns/reading)\n", "Meter", "Format", "virtual", "static");
+	compare<RI_D19_80_C>("RI-D19-80-C", iterations);
+	compare<PZEM_004T_100A>("PZEM-004T-100A", iterations);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/*
+ * power-meter - Arduino Power Meter Modbus Client
+ * Copyright 2026  Simon Arlott
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "Notify.hpp"
+#include "Poller.hpp"
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s -p DEVICE[,MODEL[,ADDRESS]] [-p ...] [-n INTERFACE] [-i SECONDS] [-v]\n", name);
+	fprintf(stderr, "  -p DEVICE     serial port of an RS485 bus (each bus is read by its own thread)\n");
+	fprintf(stderr, "     MODEL      RI-D19-80-C (default) or PZEM-004T-100A\n");
+	fprintf(stderr, "     ADDRESS    Modbus address of the meter (default 1)\n");
+	fprintf(stderr, "  -n INTERFACE  network interface to transmit on (default from the routing table)\n");
+	fprintf(stderr, "  -i SECONDS    statistics interval (default 10)\n");
+	fprintf(stderr, "  -v            log statistics to stderr\n");
+}
+
+static bool parseBus(const char *arg, Poller::Bus &bus) {
+	std::string value{arg};
+	size_t pos = value.find(',');
+
+	bus.device = value.substr(0, pos);
+	if (bus.device.empty()) {
+		return false;
+	}
+
+	if (pos != std::string::npos) {
+		std::string model;
+		size_t end = value.find(',', pos + 1);
+
+		model = value.substr(pos + 1, end == std::string::npos ? end : end - pos - 1);
+		if (!Poller::parseModel(model, bus.model)) {
+			return false;
+		}
+
+		if (end != std::string::npos) {
+			char *endptr = nullptr;
+			unsigned long address = strtoul(value.c_str() + end + 1, &endptr, 0);
+
+			if (endptr == value.c_str() + end + 1 || *endptr != '\0' || address < 1 || address > 247) {
+				return false;
+			}
+
+			bus.address = address;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	std::vector<Poller::Bus> buses;
+	std::string interface;
+	unsigned int interval = 10;
+	bool verbose = false;
+	sigset_t signals;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:n:i:vh")) != -1) {
+		switch (opt) {
+		case 'p':
+			buses.emplace_back();
+			if (!parseBus(optarg, buses.back())) {
+				fprintf(stderr, "Invalid bus: %s\n", optarg);
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+
+		case 'n':
+			interface = optarg;
+			break;
+
+		case 'i':
+			interval = strtoul(optarg, nullptr, 10);
+			if (interval == 0) {
+				interval = 1;
+			}
+			break;
+
+		case 'v':
+			verbose = true;
+			break;
+
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if (buses.empty()) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// Handle signals synchronously in the main thread
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigaddset(&signals, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+	Poller poller{buses, interface};
+	if (!poller.start()) {
+		return EXIT_FAILURE;
+	}
+
+	notify("READY=1");
+
+	while (true) {
+		struct timespec timeout{(time_t)interval, 0};
+		int sig = sigtimedwait(&signals, nullptr, &timeout);
+
+		if (sig == SIGINT || sig == SIGTERM) {
+			break;
+		}
+
+		std::vector<Poller::Statistics> stats = poller.statistics();
+		std::string status;
+
+		for (size_t i = 0; i < stats.size(); i++) {
+			char text[256];
+
+			snprintf(text, sizeof(text), "%s%s: %llu readings, %llu failures",
+				i > 0 ? "; " : "", buses[i].device.c_str(),
+				(unsigned long long)stats[i].readings, (unsigned long long)stats[i].failures);
+			status += text;
+		}
+
+		notify("STATUS=" + status);
+		if (verbose) {
+			fprintf(stderr, "%s\n", status.c_str());
+		}
+	}
+
+	notify("STOPPING=1");
+	poller.stop();
+	return EXIT_SUCCESS;
+}
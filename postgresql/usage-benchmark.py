@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+#
+# power-meter - Arduino Power Meter Modbus Client
+# Copyright 2026  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Compare meter_reading_usage_rescale() for one period at a time with the
+# set-based version for all periods at once, using synthetic readings. The
+# time taken to read the same periods from the hourly/daily rollups is also
+# reported.
+#
+# The database must already have the schema loaded; everything is done in
+# a transaction that is rolled back afterwards.
+
+import argparse
+import datetime
+import psycopg2
+import psycopg2.extras
+import random
+import time
+
+WRAP_DIGITS = 4
+
+def load_readings(c, meter, start, days, interval, offset, power, ratio):
+	rows = []
+	value = 0
+	ts = start + datetime.timedelta(seconds=offset)
+	stop = start + datetime.timedelta(days=days)
+
+	while ts < stop:
+		rows.append((meter, ts, round(value % 10**WRAP_DIGITS, 3)))
+		value += random.uniform(power / 10, power) * ratio * interval / 3600
+		ts += datetime.timedelta(seconds=interval)
+
+	c.execute("SELECT readings_create_partitions(%s, %s)", (start, stop))
+	psycopg2.extras.execute_values(c, "INSERT INTO readings_active (meter, ts, value) VALUES %s", rows, page_size=10000)
+	c.execute("SELECT readings_rollup('active', %s, %s, %s)", (meter, start, stop))
+	return len(rows)
+
+def create_meter(c, name):
+	c.execute("INSERT INTO meters (name, major_digits, minor_digits) VALUES (%s, %s, 3) RETURNING id", (name, WRAP_DIGITS))
+	return c.fetchone()[0]
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Power Meter usage function benchmark")
+	parser.add_argument("-d", "--dsn", metavar="DSN", type=str, required=True, help="database connection string")
+	parser.add_argument("-D", "--days", metavar="DAYS", type=int, default=365, help="days of readings")
+	parser.add_argument("-i", "--interval", metavar="SECONDS", type=int, default=60, help="time between readings")
+	parser.add_argument("-p", "--power", metavar="KW", type=float, default=5, help="maximum power")
+	args = parser.parse_args()
+
+	random.seed(0)
+	conn = psycopg2.connect(args.dsn)
+	try:
+		c = conn.cursor()
+		start = datetime.datetime(2026, 1, 1, tzinfo=datetime.timezone.utc)
+
+		base_meter = create_meter(c, "benchmark base meter")
+		meter = create_meter(c, "benchmark meter")
+		count = load_readings(c, base_meter, start, args.days, args.interval, args.interval // 8, args.power, 1)
+		count += load_readings(c, meter, start, args.days, args.interval, args.interval // 2, args.power, 0.98)
+		c.execute("ANALYZE readings_active")
+		print("Loaded {0} readings".format(count))
+
+		periods = [psycopg2.extras.DateTimeTZRange(start + datetime.timedelta(days=day), start + datetime.timedelta(days=day + 1), "[)") for day in range(args.days)]
+
+		before = time.monotonic()
+		c.execute("SELECT meter_reading_usage_rescale(%s, %s, lower(period), upper(period)) FROM unnest(%s::tstzrange[]) AS period", (base_meter, meter, periods))
+		single = [row[0] for row in c.fetchall()]
+		single_elapsed = time.monotonic() - before
+
+		before = time.monotonic()
+		c.execute("SELECT usage FROM meter_reading_usage_rescale(%s, %s, %s::tstzrange[]) ORDER BY period", (base_meter, meter, periods))
+		series = [row[0] for row in c.fetchall()]
+		series_elapsed = time.monotonic() - before
+
+		before = time.monotonic()
+		c.execute("SELECT meter_usage(%s, lower(period), upper(period)) FROM unnest(%s::tstzrange[]) AS period", (meter, periods))
+		c.fetchall()
+		rollup_elapsed = time.monotonic() - before
+
+		mismatches = sum(1 for (a, b) in zip(single, series) if a != b)
+		print("{0:>12}: {1:>8.3f}s".format("per period", single_elapsed))
+		print("{0:>12}: {1:>8.3f}s".format("set-based", series_elapsed))
+		print("{0:>12}: {1:>8.1f}×".format("speedup", single_elapsed / series_elapsed))
+		print("{0:>12}: {1:>8.3f}s (without rescaling)".format("rollups", rollup_elapsed))
+		print("{0:>12}: {1} of {2} periods".format("mismatches", mismatches, len(periods)))
+	finally:
+		conn.rollback()
+		conn.close()
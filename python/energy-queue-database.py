@@ -18,11 +18,11 @@
 
 import argparse
 import datetime
-import decimal
 import logging
 import logging.handlers
 import os
 import posix_ipc
+import powermeter
 import psycopg2
 import psycopg2.extras
 import psycopg2.pool
@@ -35,28 +35,53 @@ import traceback
 
 log = logging.getLogger("readings")
 db = None
-
-def cursor_insert_value(c, meter, ts, name, value):
-	exists = False
-
-	c.execute("SELECT 1 FROM readings_" + name + " WHERE meter = %(meter)s AND ts = %(ts)s", { "meter": meter, "ts": ts })
-	if c.fetchone():
-		exists = True
-
-	if not exists:
-		c.execute("SELECT value FROM readings_" + name + " WHERE meter = %(meter)s ORDER BY ts DESC LIMIT 1", { "meter": meter })
-		row = c.fetchone()
-		if row:
-			if row["value"] == decimal.Decimal(value).quantize(row["value"]) or row["ts"]:
-				exists = True
-
-	if not exists:
-		c.execute("INSERT INTO readings_" + name + " (meter, ts, value) VALUES(%(meter)s, %(ts)s, %(value)s)", { "meter": meter, "ts": ts, "value": value })
-
-	return "{1:.3f} ({0}) {2}".format(name, value, "exists" if exists else "inserted")
-
-def database_insert(meter, dsn, ts, active_energy, reactive_energy):
-	global db
+partitions = set()
+
+# Insert readings, skipping those that already exist or have the same value
+# as the previous reading (including previous readings in the same batch)
+INSERT_SQL = """
+WITH input AS (
+	SELECT DISTINCT ON (ts) ts::timestamp with time zone AS ts, value::numeric(9,3) AS value
+	FROM (VALUES %s) AS batch(ts, value)
+	ORDER BY ts
+), previous AS (
+	SELECT ts, value FROM readings_{0}
+	WHERE meter = {meter} AND ts < (SELECT min(ts) FROM input)
+	ORDER BY ts DESC LIMIT 1
+), changes AS (
+	SELECT ts, value, new, lag(value) OVER (ORDER BY ts) AS prev_value FROM (
+		SELECT ts, value, false AS new FROM previous
+		UNION ALL
+		SELECT ts, value, true AS new FROM input
+	) AS combined
+)
+INSERT INTO readings_{0} (meter, ts, value)
+SELECT {meter}, ts, value FROM changes
+WHERE new AND value IS DISTINCT FROM prev_value
+ON CONFLICT (meter, ts) DO NOTHING
+"""
+
+BATCH_SIZE = 1000
+BATCH_LATENCY = 1.0
+
+def cursor_insert_values(c, meter, name, rows):
+	rows = [(ts, value) for (ts, value) in rows if value is not None]
+	if not rows:
+		return 0
+
+	psycopg2.extras.execute_values(c, INSERT_SQL.format(name, meter=c.mogrify("%s", (meter,)).decode("utf-8")), rows, page_size=len(rows))
+	inserted = c.rowcount
+
+	# Add the batch to the hourly/daily rollups (or recalculate them for the
+	# period of the batch and the next stored reading, if it's late)
+	if inserted:
+		c.execute("SELECT readings_rollup(%(name)s, %(meter)s, %(start)s, %(stop)s)",
+			{ "name": name, "meter": meter, "start": min(ts for (ts, value) in rows), "stop": max(ts for (ts, value) in rows) })
+
+	return inserted
+
+def database_insert(meter, dsn, batch):
+	global db, partitions
 
 	try:
 		backoff = 0
@@ -71,15 +96,24 @@ def database_insert(meter, dsn, ts, active_energy, reactive_energy):
 				conn = db.getconn()
 				c = conn.cursor()
 
-				msg = cursor_insert_value(c, meter, ts, "active", active_energy)
-				if reactive_energy is not None:
-					msg += "; "
-					msg += cursor_insert_value(c, meter, ts, "reactive", reactive_energy)
+				start = time.monotonic()
+				months = set((ts.year, ts.month) for (ts, active_energy, reactive_energy) in batch)
+				if not months <= partitions:
+					c.execute("SELECT readings_create_partitions(%(start)s, %(stop)s)",
+						{ "start": min(ts for (ts, active_energy, reactive_energy) in batch), "stop": max(ts for (ts, active_energy, reactive_energy) in batch) })
 
-				systemd.daemon.notify("STATUS=Meter {0} at {1}: {2}".format(meter, ts, msg))
+				active = cursor_insert_values(c, meter, "active", [(ts, active_energy) for (ts, active_energy, reactive_energy) in batch])
+				reactive = cursor_insert_values(c, meter, "reactive", [(ts, reactive_energy) for (ts, active_energy, reactive_energy) in batch])
 
 				conn.commit()
 				c.close()
+				partitions |= months
+
+				elapsed = time.monotonic() - start
+				rate = len(batch) / elapsed if elapsed > 0 else 0
+				msg = "{0} readings up to {1}: inserted {2} active, {3} reactive ({4:.0f} rows/s)".format(len(batch), batch[-1][0], active, reactive, rate)
+				log.info("Meter {0}: {1}".format(meter, msg))
+				systemd.daemon.notify("STATUS=Meter {0}: {1}".format(meter, msg))
 
 				return
 			except KeyboardInterrupt:
@@ -92,6 +126,12 @@ def database_insert(meter, dsn, ts, active_energy, reactive_energy):
 
 				systemd.daemon.notify("STATUS=Database access error: " + str(sys.exc_info()[1]))
 
+				if conn:
+					try:
+						conn.rollback()
+					except:
+						pass
+
 				time.sleep(30 + backoff)
 				if backoff < 30:
 					backoff += 1
@@ -106,29 +146,72 @@ def database_insert(meter, dsn, ts, active_energy, reactive_energy):
 
 		raise
 
+def decode_message(data):
+	if len(data) >= 24:
+		(ts, active_energy, reactive_energy) = struct.unpack("=Qdd", data)
+	elif len(data) >= 16:
+		(ts, active_energy) = struct.unpack("=Qd", data)
+		reactive_energy = None
+	else:
+		return None
+
+	ts = pytz.utc.localize(datetime.datetime.utcfromtimestamp(ts))
+	return (ts, active_energy, reactive_energy)
+
 def receive_loop(mq_name, dsn, meter):
 	queue = posix_ipc.MessageQueue(mq_name, flags=posix_ipc.O_CREAT, max_messages=8192, max_message_size=8+8+8, write=False)
 
 	systemd.daemon.notify("READY=1")
 
 	while True:
+		batch = []
+
+		# Wait for a message, then take everything that arrives within the
+		# batch latency (or until the batch is full) for one transaction
 		(data, priority) = queue.receive()
+		deadline = time.monotonic() + BATCH_LATENCY
+
+		while True:
+			message = decode_message(data)
+			if message:
+				batch.append(message)
+
+			if len(batch) >= BATCH_SIZE:
+				break
+
+			try:
+				(data, priority) = queue.receive(timeout=max(0, deadline - time.monotonic()))
+			except posix_ipc.BusyError:
+				break
+
+		if batch:
+			database_insert(meter, dsn, batch)
+
+def spool_loop(spool_file, dsn, meter):
+	spool = powermeter.Spool(spool_file, powermeter.Spool.READER)
+
+	systemd.daemon.notify("READY=1")
+
+	while True:
+		# Wait for more readings unless there's a full batch (e.g. after
+		# an outage) to replay
+		if len(spool) < BATCH_SIZE:
+			time.sleep(BATCH_LATENCY)
 
-		if len(data) >= 24:
-			(ts, active_energy, reactive_energy) = struct.unpack("=Qdd", data)
-		elif len(data) >= 16:
-			(ts, active_energy) = struct.unpack("=Qd", data)
-			reactive_energy = None
-		else:
+		records = spool.read(BATCH_SIZE)
+		if not records:
 			continue
 
-		ts = pytz.utc.localize(datetime.datetime.utcfromtimestamp(ts))
-		database_insert(meter, dsn, ts, active_energy, reactive_energy)
+		batch = [(pytz.utc.localize(datetime.datetime.utcfromtimestamp(ts)), active_energy, reactive_energy) for (ts, active_energy, reactive_energy) in records]
+		database_insert(meter, dsn, batch)
+		spool.consume(len(records))
 
 if __name__ == "__main__":
 	parser = argparse.ArgumentParser(description="Power Meter energy queue database client")
 	parser.add_argument("-m", "--meter", metavar="METER", type=str, required=True, help="meter identifier")
-	parser.add_argument("-q", "--queue", metavar="NAME", type=str, required=True, help="message queue to read energy readings from")
+	source = parser.add_mutually_exclusive_group(required=True)
+	source.add_argument("-q", "--queue", metavar="NAME", type=str, help="message queue to read energy readings from")
+	source.add_argument("-p", "--spool", metavar="FILE", type=str, help="spool file to read energy readings from")
 	parser.add_argument("-d", "--database", metavar="NAME", type=str, required=True, help="message queue to read energy readings from")
 	args = parser.parse_args()
 
@@ -136,4 +219,7 @@ if __name__ == "__main__":
 	syslog.ident = "energy-queue-database[{0}]: ".format(os.getpid())
 	logging.basicConfig(level=logging.INFO, format="%(message)s", handlers=[syslog])
 
-	receive_loop(args.queue, args.database, args.meter)
+	if args.spool:
+		spool_loop(args.spool, args.database, args.meter)
+	else:
+		receive_loop(args.queue, args.database, args.meter)
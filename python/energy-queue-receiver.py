@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 #
 # power-meter - Arduino Power Meter Modbus Client
-# Copyright 2017  Simon Arlott
+# Copyright 2017,2026  Simon Arlott
 #
 # This program is free software: you can redistribute it and/or modify
 # it under the terms of the GNU General Public License as published by
@@ -27,9 +27,12 @@ import systemd.daemon
 
 log = logging.getLogger("readings")
 
-def receive_loop(mq_name, serial_numbers=None, ip4_numbers=None):
-	queue = posix_ipc.MessageQueue(mq_name, flags=posix_ipc.O_CREAT, max_messages=8192//100, max_message_size=8+8+8, read=False)
-	meter = powermeter.PowerMeter(serial_numbers, ip4_numbers)
+def receive_loop(mq_name, serial_numbers=None, ip4_numbers=None, collector=None, spool_file=None, shared=None):
+	if spool_file:
+		spool = powermeter.Spool(spool_file, powermeter.Spool.WRITER)
+	else:
+		queue = posix_ipc.MessageQueue(mq_name, flags=posix_ipc.O_CREAT, max_messages=8192//100, max_message_size=8+8+8, read=False)
+	meter = powermeter.PowerMeter(serial_numbers, ip4_numbers, collector=collector, shared=shared)
 	last = None
 
 	systemd.daemon.notify("READY=1")
@@ -47,6 +50,15 @@ def receive_loop(mq_name, serial_numbers=None, ip4_numbers=None):
 			data += struct.pack("=d", reading.reactiveEnergy)
 			message += [str(reading.reactiveEnergy)]
 
+		if spool_file:
+			if spool.append(ts, reading.activeEnergy, reading.reactiveEnergy):
+				log.info("wrote {0} to spool".format(" ".join(message)))
+				systemd.daemon.notify("STATUS=Reading at {0}: ".format(reading.ts) + ", ".join(message[1:]) + " OK ({0} pending)".format(len(spool)))
+			else:
+				log.error("spool full writing {0}".format(" ".join(message)))
+				systemd.daemon.notify("STATUS=Reading at {0}: ".format(reading.ts) + ", ".join(message[1:]) + " SPOOL FULL")
+			continue
+
 		try:
 			queue.send(data, timeout=0)
 			log.info("wrote {0} to queue".format(" ".join(message)))
@@ -62,11 +74,15 @@ if __name__ == "__main__":
 	parser = argparse.ArgumentParser(description="Power Meter energy queue receiver")
 	parser.add_argument("-m", "--meter", metavar="SERIAL_NUMBER", type=str, action="append", help="filter power meter by serial number")
 	parser.add_argument("-s", "--source", metavar="IP_ADDRESS", type=str, action="append", help="filter power meter by IP address")
-	parser.add_argument("-q", "--queue", metavar="NAME", type=str, required=True, help="message queue to store energy readings in")
+	parser.add_argument("-c", "--collector", metavar="SOCKET", type=str, nargs="?", const=powermeter.COLLECTOR_PATH, help="receive readings from power-meter-collector")
+	parser.add_argument("-S", "--shared", metavar="PATH", type=str, nargs="?", const=powermeter.SHARED_PATH, help="read readings from power-meter-collector shared memory")
+	output = parser.add_mutually_exclusive_group(required=True)
+	output.add_argument("-q", "--queue", metavar="NAME", type=str, help="message queue to store energy readings in")
+	output.add_argument("-p", "--spool", metavar="FILE", type=str, help="spool file to store energy readings in")
 	args = parser.parse_args()
 
 	syslog = logging.handlers.SysLogHandler("/dev/log")
 	syslog.ident = "energy-queue-receiver[{0}]: ".format(os.getpid())
 	logging.basicConfig(level=logging.INFO, format="%(message)s", handlers=[syslog])
 
-	receive_loop(args.queue, args.meter, args.source)
+	receive_loop(args.queue, args.meter, args.source, args.collector, args.spool, args.shared)
@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 #
 # power-meter - Arduino Power Meter Modbus Client
-# Copyright 2020  Simon Arlott
+# Copyright 2020,2026  Simon Arlott
 #
 # This program is free software: you can redistribute it and/or modify
 # it under the terms of the GNU General Public License as published by
@@ -25,6 +25,7 @@ import re
 import socket
 import sys
 import systemd.daemon
+import time
 import traceback
 
 log = logging.getLogger("readings")
@@ -32,71 +33,164 @@ hostname = socket.getfqdn()
 udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
 udp.connect(("127.0.0.1", 8089))
 
+# Time to wait for late readings before outputting an interval's aggregate
+# values when there are no readings from the meter for the next interval
+AGGREGATE_GRACE = 5
+
+KEYS = {
+	"voltage": "electricity:supply,traits=metric:gauge",
+	"frequency": "electricity:supply,traits=metric:gauge",
+	"temperature": "temperature,traits=metric:gauge,sensor=external:power-meter",
+	"current": "electricity:load,traits=metric:gauge",
+	"activePower": "electricity:meter,traits=metric:counter",
+	"reactivePower": "electricity:meter,traits=metric:counter",
+	"apparentPower": "electricity:meter,traits=metric:counter",
+	"powerFactor": "electricity:load,traits=metric:gauge"
+}
+
+NAMES = {
+	"voltage": "voltage:V",
+	"frequency": "frequency:Hz",
+	"temperature": "celsius",
+	"current": "current:A",
+	"activePower": "power:kWh",
+	"reactivePower": "power:kWh",
+	"apparentPower": "power:kWh",
+	"powerFactor": "power-factor:percent"
+}
+
+class Output:
+	"""Lines for the current interval from all meters, sent in as few datagrams as possible"""
+
+	def __init__(self):
+		self.lines = []
+		self.flush_after = None
+
+	def add(self, line, flush_after):
+		self.lines.append(line)
+		self.flush_after = flush_after
+
+	def tick(self, now):
+		if self.lines and now > self.flush_after:
+			self.flush()
+
+	def flush(self):
+		datagrams = []
+		data = b""
+		for line in self.lines:
+			line = line.encode("utf-8")
+			if data and len(data) + len(line) > powermeter.MAX_LENGTH:
+				datagrams.append(data)
+				data = b""
+			data += line
+		datagrams.append(data)
+
+		try:
+			for data in datagrams:
+				udp.send(data)
+			systemd.daemon.notify("STATUS=Sent {0} lines in {1} datagrams at {2}".format(len(self.lines), len(datagrams), self.flush_after))
+		except ConnectionRefusedError as e:
+			systemd.daemon.notify("STATUS=" + str(e))
+
+		self.lines = []
+
 class InfluxDB:
-	def __init__(self, location, fields, interval, serial_number):
-		self.location = location
-		self.fields = set(fields) & set(["voltage", "frequency", "temperature", "current", "activePower", "reactivePower", "apparentPower", "powerFactor"])
+	def __init__(self, location, fields, interval, serial_number, output, aggregate=False):
 		self.interval = interval
-		self.serial_number = serial_number
+		self.output = output
+		self.aggregate = aggregate
+
+		# Line prefix (measurement, tags and field name) for each field
+		tags = ",host=" + hostname + ",location=" + location + ",power-meter:serial_number=" + serial_number
+		self.fields = [(field, KEYS[field] + tags + " " + NAMES[field]) for field in collections.OrderedDict.fromkeys(fields) if field in KEYS]
+
+		self.start = None
+		self.flushed = None
+		self.values = {}
 
 	def update(self, reading):
 		now = int(reading.ts.timestamp())
+
+		if self.aggregate:
+			start = now - now % self.interval
+			if self.flushed is not None and start <= self.flushed:
+				# Too late, the interval has already been output
+				return
+
+			if start != self.start:
+				self.__flush(now)
+				self.start = start
+
+			for (field, prefix) in self.fields:
+				value = reading[field]
+				if value is not None:
+					if field in self.values:
+						(total, count, minimum, maximum) = self.values[field]
+						self.values[field] = (total + value, count + 1, min(minimum, value), max(maximum, value))
+					else:
+						self.values[field] = (value, 1, value, value)
+			return
+
 		if now % self.interval != 0:
 			return
 
-		data = ""
-		for field in self.fields:
-			key = {
-				"voltage": "electricity:supply,traits=metric:gauge",
-				"frequency": "electricity:supply,traits=metric:gauge",
-				"temperature": "temperature,traits=metric:gauge,sensor=external:power-meter",
-				"current": "electricity:load,traits=metric:gauge",
-				"activePower": "electricity:meter,traits=metric:counter",
-				"reactivePower": "electricity:meter,traits=metric:counter",
-				"apparentPower": "electricity:meter,traits=metric:counter",
-				"powerFactor": "electricity:load,traits=metric:gauge"
-			}[field] + ",host=" + hostname + ",location=" + self.location + ",power-meter:serial_number=" + self.serial_number
-			name = {
-				"voltage": "voltage:V",
-				"frequency": "frequency:Hz",
-				"temperature": "celsius",
-				"current": "current:A",
-				"activePower": "power:kWh",
-				"reactivePower": "power:kWh",
-				"apparentPower": "power:kWh",
-				"powerFactor": "power-factor:percent"
-			}[field]
+		for (field, prefix) in self.fields:
 			if reading[field] is not None:
-				data += "{0} {1}={2} {3}000000000\n".format(key, name, reading[field], now)
+				self.output.add("{0}={1} {2}000000000\n".format(prefix, reading[field], now), now)
 
-		if data:
-			try:
-				udp.send(data.encode("utf-8"))
-				systemd.daemon.notify("STATUS=Updated reading at " + str(reading.ts))
-			except ConnectionRefusedError as e:
-				systemd.daemon.notify("STATUS=" + str(e))
+	def tick(self, now):
+		"""Output the aggregate values for an interval that ended without a reading for the next one"""
+		if self.values and now >= self.start + self.interval + AGGREGATE_GRACE:
+			self.__flush(now)
 
-def receive_loop(location, fields, interval, serial_numbers=None, ip4_numbers=None):
-	meter = powermeter.PowerMeter(serial_numbers, ip4_numbers)
+	def __flush(self, now):
+		"""Output the mean/min/max for the previous interval"""
+		if not self.values:
+			return
+
+		for (field, prefix) in self.fields:
+			if field in self.values:
+				(total, count, minimum, maximum) = self.values[field]
+				self.output.add("{0}={1},{2}:min={3},{2}:max={4} {5}000000000\n".format(
+					prefix, round(total / count, 3), prefix.rsplit(" ", 1)[1], minimum, maximum, self.start), now)
+		self.values = {}
+		self.flushed = self.start
+
+def receive_loop(location, fields, interval, serial_numbers=None, ip4_numbers=None, collector=None, aggregate=False, shared=None):
+	meter = powermeter.PowerMeter(serial_numbers, ip4_numbers, collector=collector, shared=shared)
+	output = Output()
 	meters = {}
 
 	systemd.daemon.notify("READY=1")
 
-	for reading in meter.readings:
-		if reading.serialNumber not in meters:
-			meters[reading.serialNumber] = InfluxDB(location, fields, interval, reading.serialNumber)
-		meters[reading.serialNumber].update(reading)
+	while True:
+		# Wake up at least every second to output intervals from meters
+		# that have stopped sending readings
+		for reading in meter.poll(1):
+			output.tick(int(reading.ts.timestamp()))
+
+			if reading.serialNumber not in meters:
+				meters[reading.serialNumber] = InfluxDB(location, fields, interval, reading.serialNumber, output, aggregate)
+			meters[reading.serialNumber].update(reading)
+
+		now = int(time.time())
+		for influxdb in meters.values():
+			influxdb.tick(now)
+		output.tick(now)
 
 if __name__ == "__main__":
 	parser = argparse.ArgumentParser(description="Power Meter receiver for InfluxDB file store")
 	parser.add_argument("-v", "--verbose", action="store_const", default=logging.ERROR, const=logging.INFO, help="verbose mode")
 	parser.add_argument("-m", "--meter", metavar="SERIAL_NUMBER", type=str, action="append", help="filter power meter by serial number")
 	parser.add_argument("-s", "--source", metavar="IP_ADDRESS", type=str, action="append", help="filter power meter by IP address")
+	parser.add_argument("-c", "--collector", metavar="SOCKET", type=str, nargs="?", const=powermeter.COLLECTOR_PATH, help="receive readings from power-meter-collector")
+	parser.add_argument("-S", "--shared", metavar="PATH", type=str, nargs="?", const=powermeter.SHARED_PATH, help="read readings from power-meter-collector shared memory")
 	parser.add_argument("-l", "--location", metavar="LOCATION", type=str, required=True, help="location")
 	parser.add_argument("-f", "--field", metavar="FIELD", type=str, required=True, action="append", help="field to output")
 	parser.add_argument("-i", "--interval", metavar="SECONDS", type=int, default=60, help="output interval")
+	parser.add_argument("-a", "--aggregate", action="store_true", help="output the mean/min/max over each interval instead of a sample")
 	args = parser.parse_args()
 
 	logging.basicConfig(level=args.verbose, format="%(asctime)s.%(msecs)03d  %(levelname)5s  %(message)s", datefmt="%F %T")
 
-	receive_loop(args.location, args.field, args.interval, args.meter, args.source)
+	receive_loop(args.location, args.field, args.interval, args.meter, args.source, args.collector, args.aggregate, args.shared)
@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 #
 # power-meter - Arduino Power Meter Modbus Client
-# Copyright 2017  Simon Arlott
+# Copyright 2017,2026  Simon Arlott
 #
 # This program is free software: you can redistribute it and/or modify
 # it under the terms of the GNU General Public License as published by
@@ -21,7 +21,6 @@ from math import ceil
 import argparse
 import logging
 import matplotlib
-import matplotlib.animation as animation
 import matplotlib.dates as mdates
 import matplotlib.gridspec as gspec
 import matplotlib.pyplot as plt
@@ -30,16 +29,14 @@ import numpy as np
 import powermeter
 import tzlocal
 
-history = timedelta(seconds=60)
 matplotlib.rcParams["toolbar"] = "None"
 matplotlib.rcParams["timezone"] = tzlocal.get_localzone()
 
-def receive_loop(serial_numbers=None, ip4_numbers=None):
-	meter = powermeter.PowerMeterNumPy(serial_numbers, ip4_numbers, always_yield=True, history=history)
-	readings = meter.readings
+def receive_loop(serial_numbers=None, ip4_numbers=None, collector=None, history=timedelta(seconds=60), rate=1, shared=None):
+	meter = powermeter.PowerMeterNumPy(serial_numbers, ip4_numbers, always_yield=True, history=history, collector=collector, shared=shared, rate=rate)
 
 	fig = plt.figure()
-	fig.canvas.set_window_title("Power Meter")
+	fig.canvas.manager.set_window_title("Power Meter")
 	gs = gspec.GridSpec(3, 1)
 
 	ax_supply = plt.subplot(gs[0, :])
@@ -82,31 +79,77 @@ def receive_loop(serial_numbers=None, ip4_numbers=None):
 
 	fig.autofmt_xdate(rotation=45)
 
-	def animate(i):
-		reading = next(readings)
-		if reading is not None:
-			voltage.set_data(reading.ts, reading.voltage)
-			frequency.set_data(reading.ts, reading.frequency)
-			hz = round(np.nanmedian(reading.frequency))
-			ax_supply.set_xlim(reading.ts[0], reading.ts[-1])
-			ax_supply.set_ylim(np.nanmin(reading.voltage) - 0.5, np.nanmax(reading.voltage) + 0.5)
-			ax_supply_2.set_ylim(hz * 0.99, hz * 1.01)
+	lines = (voltage, frequency, current, active_power, reactive_power, apparent_power)
+	for line in lines:
+		line.set_animated(True)
+	background = None
+
+	def on_draw(event):
+		nonlocal background
+		background = fig.canvas.copy_from_bbox(fig.bbox)
+		draw_lines()
+
+	def draw_lines():
+		for line in lines:
+			line.axes.draw_artist(line)
+
+	def in_limits(ax, values):
+		(bottom, top) = ax.get_ylim()
+		return np.all(np.isnan(values) | ((values >= bottom) & (values <= top)))
+
+	def set_limits(data):
+		# Leave space for more readings and changes in values so that the
+		# axes (which can't be blitted) only need to be redrawn occasionally
+		xlim = (data.ts[-1] - np.timedelta64(history), data.ts[-1] + np.timedelta64(history / 10))
+		hz = round(np.nanmedian(data.frequency))
+		ax_supply.set_xlim(*xlim)
+		ax_supply.set_ylim(np.floor(np.nanmin(data.voltage)) - 1, np.ceil(np.nanmax(data.voltage)) + 1)
+		ax_supply_2.set_ylim(hz * 0.99, hz * 1.01)
+
+		ax_current.set_xlim(*xlim)
+		ax_current.set_ylim(np.nanmin(data.current) * 0.5, ceil(np.nanmax(data.current)) * 2)
+
+		ax_power.set_xlim(*xlim)
+		all_power = np.concatenate((data.activePower, data.reactivePower, data.apparentPower))
+		ax_power.set_ylim(np.nanmin(all_power) * 0.5, ceil(np.nanmax(all_power)) * 2)
+
+	def update(*args):
+		if not meter.poll(0):
+			return True
+
+		data = meter.window
+		voltage.set_data(data.ts, data.voltage)
+		frequency.set_data(data.ts, data.frequency)
+		current.set_data(data.ts, data.current)
+		active_power.set_data(data.ts, data.activePower)
+		reactive_power.set_data(data.ts, data.reactivePower)
+		apparent_power.set_data(data.ts, data.apparentPower)
+
+		if (background is None or mdates.date2num(data.ts[-1]) > ax_supply.get_xlim()[1]
+				or not in_limits(ax_supply, data.voltage) or not in_limits(ax_supply_2, data.frequency)
+				or not in_limits(ax_current, data.current)
+				or not in_limits(ax_power, np.concatenate((data.activePower, data.reactivePower, data.apparentPower)))):
+			set_limits(data)
+			fig.canvas.draw_idle()
+		else:
+			fig.canvas.restore_region(background)
+			draw_lines()
+			fig.canvas.blit(fig.bbox)
+		return True
+
+	fig.canvas.mpl_connect("draw_event", on_draw)
+
+	# Redraw when readings are received, using the Tk event loop to wait
+	# for them if possible and otherwise checking for them regularly
+	fd = meter.fileno()
+	if fd is not None and matplotlib.get_backend().lower().startswith("tk"):
+		import tkinter
+		fig.canvas.get_tk_widget().tk.createfilehandler(fd, tkinter.READABLE, update)
+	else:
+		timer = fig.canvas.new_timer(interval=100)
+		timer.add_callback(update)
+		timer.start()
 
-			current.set_data(reading.ts, reading.current)
-			ax_current.set_xlim(reading.ts[0], reading.ts[-1])
-			ax_current.set_ylim(np.nanmin(reading.current) * 0.5, ceil(np.nanmax(reading.current)) * 2)
-
-			active_power.set_data(reading.ts, reading.activePower)
-			reactive_power.set_data(reading.ts, reading.reactivePower)
-			apparent_power.set_data(reading.ts, reading.apparentPower)
-
-			ax_power.set_xlim(reading.ts[0], reading.ts[-1])
-			all_power = np.concatenate((reading.activePower, reading.reactivePower, reading.apparentPower))
-			ax_power.set_ylim(np.nanmin(all_power) * 0.5, ceil(np.nanmax(all_power)) * 2)
-
-		return (voltage, frequency, current, active_power, reactive_power, apparent_power)
-
-	ani = animation.FuncAnimation(fig, animate, interval=100, blit=False)
 	plt.show()
 
 if __name__ == "__main__":
@@ -114,8 +157,12 @@ if __name__ == "__main__":
 	parser.add_argument("-d", "--debug", action="store_const", default=logging.INFO, const=logging.DEBUG, help="enable debug")
 	parser.add_argument("-m", "--meter", metavar="SERIAL_NUMBER", type=str, action="append", help="filter power meter by serial number")
 	parser.add_argument("-s", "--source", metavar="IP_ADDRESS", type=str, action="append", help="filter power meter by IP address")
+	parser.add_argument("-c", "--collector", metavar="SOCKET", type=str, nargs="?", const=powermeter.COLLECTOR_PATH, help="receive readings from power-meter-collector")
+	parser.add_argument("-S", "--shared", metavar="PATH", type=str, nargs="?", const=powermeter.SHARED_PATH, help="read readings from power-meter-collector shared memory")
+	parser.add_argument("-H", "--history", metavar="SECONDS", type=float, default=60, help="history to display")
+	parser.add_argument("-r", "--rate", metavar="HZ", type=float, default=1, help="expected reading rate (from all meters)")
 	args = parser.parse_args()
 
 	logging.basicConfig(level=args.debug, format="%(asctime)s.%(msecs)03d  %(levelname)5s  %(message)s", datefmt="%F %T")
 
-	receive_loop(args.meter, args.source)
+	receive_loop(args.meter, args.source, args.collector, timedelta(seconds=args.history), args.rate, args.shared)
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+#
+# power-meter - Arduino Power Meter Modbus Client
+# Copyright 2026  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Simulate a meter on a pseudo-terminal, to test power-meter-poller without
+# an RS485 adapter. The readings are fixed apart from the energy counters,
+# which increase over time.
+
+import argparse
+import logging
+import os
+import powermeter
+import select
+import signal
+import struct
+import sys
+import time
+import tty
+
+log = logging.getLogger("simulator")
+
+READ_HOLDING_REGISTERS = 3
+READ_INPUT_REGISTERS = 4
+
+ILLEGAL_FUNCTION = 1
+ILLEGAL_DATA_ADDRESS = 2
+
+# Silence after a request (the pty doesn't have the RS485 character timing)
+FRAME_GAP = 0.005
+
+def ri_d19_80_c(energy):
+	"""Holding registers of an RI-D19-80-C"""
+	registers = [0] * 0x30
+	registers[0x0000] = 2401 # dV
+	registers[0x0001] = 52 # dA
+	registers[0x0002] = 500 # dHz
+	registers[0x0003] = 1187 # W
+	registers[0x0004] = 164 # var
+	registers[0x0005] = 1248 # VA
+	registers[0x0006] = 951 # ‰
+	registers[0x0007:0x0009] = [energy >> 16, energy & 0xFFFF] # daW·h
+	registers[0x0009:0x000B] = [energy >> 16, energy & 0xFFFF] # daW·h (T1)
+	registers[0x0011:0x0013] = [(energy // 10) >> 16, (energy // 10) & 0xFFFF] # davar·h
+	registers[0x0025] = 31 # °C
+	registers[0x0026] = 0xF6
+	registers[0x0027:0x002A] = [0x1234, 0x5678, 0x9012] # BCD serial number
+	return (READ_HOLDING_REGISTERS, registers)
+
+def pzem_004t_100a(energy):
+	"""Input registers of a PZEM-004T-100A"""
+	energy //= 10
+	registers = [0] * 0x0A
+	registers[0x0000] = 2401 # dV
+	registers[0x0001:0x0003] = [5200 & 0xFFFF, 5200 >> 16] # mA
+	registers[0x0003:0x0005] = [11870 & 0xFFFF, 11870 >> 16] # dW
+	registers[0x0005:0x0007] = [energy & 0xFFFF, energy >> 16] # W·h
+	registers[0x0007] = 500 # dHz
+	registers[0x0008] = 95 # c%
+	return (READ_INPUT_REGISTERS, registers)
+
+MODELS = {
+	"RI-D19-80-C": ri_d19_80_c,
+	"PZEM-004T-100A": pzem_004t_100a,
+}
+
+def frame(data):
+	return data + struct.pack("<H", powermeter.crc16(data))
+
+def respond(request, address, model, energy):
+	if len(request) < 4 or powermeter.crc16(request) != 0:
+		log.debug("Invalid request: %s", request.hex())
+		return None
+
+	if request[0] != address:
+		return None
+
+	if len(request) != 8:
+		return frame(bytes([address, request[1] | 0x80, ILLEGAL_FUNCTION]))
+
+	(function, start, count) = struct.unpack(">BHH", request[1:6])
+	(supported, registers) = model(energy)
+
+	if function != supported:
+		return frame(bytes([address, function | 0x80, ILLEGAL_FUNCTION]))
+
+	if count < 1 or start + count > len(registers):
+		return frame(bytes([address, function | 0x80, ILLEGAL_DATA_ADDRESS]))
+
+	return frame(struct.pack(">BBB{0}H".format(count), address, function, count * 2, *registers[start:start + count]))
+
+def simulate(link, address, model):
+	(master, slave) = os.openpty()
+	tty.setraw(slave)
+	name = os.ttyname(slave)
+
+	if link:
+		if os.path.lexists(link):
+			os.unlink(link)
+		os.symlink(name, link)
+	print(name, flush=True)
+
+	signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+	start = time.monotonic()
+	try:
+		while True:
+			request = os.read(master, 256)
+			while select.select([master], [], [], FRAME_GAP)[0]:
+				request += os.read(master, 256)
+
+			# 1 daW·h every second
+			response = respond(request, address, model, int(time.monotonic() - start) + 100000)
+			log.debug("%s -> %s", request.hex(), response.hex() if response else None)
+			if response:
+				os.write(master, response)
+	finally:
+		if link:
+			os.unlink(link)
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Power Meter simulator")
+	parser.add_argument("-d", "--debug", action="store_const", default=logging.INFO, const=logging.DEBUG, help="enable debug")
+	parser.add_argument("-m", "--model", choices=MODELS.keys(), default="RI-D19-80-C", help="meter model")
+	parser.add_argument("-a", "--address", metavar="ADDRESS", type=int, default=1, help="Modbus address")
+	parser.add_argument("-l", "--link", metavar="PATH", type=str, help="create a symlink to the pseudo-terminal")
+	args = parser.parse_args()
+
+	logging.basicConfig(level=args.debug, format="%(asctime)s.%(msecs)03d  %(levelname)5s  %(message)s", datefmt="%F %T")
+
+	simulate(args.link, args.address, MODELS[args.model])
@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 #
 # power-meter - Arduino Power Meter Modbus Client
-# Copyright 2017  Simon Arlott
+# Copyright 2017,2026  Simon Arlott
 #
 # This program is free software: you can redistribute it and/or modify
 # it under the terms of the GNU General Public License as published by
@@ -16,14 +16,15 @@
 # You should have received a copy of the GNU General Public License
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+from datetime import timedelta
 import argparse
 import logging
 import powermeter
 
 log = logging.getLogger("readings")
 
-def receive_loop(serial_numbers=None, ip4_numbers=None):
-	meter = powermeter.PowerMeterNumPy(serial_numbers, ip4_numbers)
+def receive_loop(serial_numbers=None, ip4_numbers=None, collector=None, history=timedelta(seconds=60), rate=1, shared=None):
+	meter = powermeter.PowerMeterNumPy(serial_numbers, ip4_numbers, history=history, collector=collector, shared=shared, rate=rate)
 	for reading in meter.readings:
 		log.info(reading)
 
@@ -32,8 +33,12 @@ if __name__ == "__main__":
 	parser.add_argument("-d", "--debug", action="store_const", default=logging.INFO, const=logging.DEBUG, help="enable debug")
 	parser.add_argument("-m", "--meter", metavar="SERIAL_NUMBER", type=str, action="append", help="filter power meter by serial number")
 	parser.add_argument("-s", "--source", metavar="IP_ADDRESS", type=str, action="append", help="filter power meter by IP address")
+	parser.add_argument("-c", "--collector", metavar="SOCKET", type=str, nargs="?", const=powermeter.COLLECTOR_PATH, help="receive readings from power-meter-collector")
+	parser.add_argument("-S", "--shared", metavar="PATH", type=str, nargs="?", const=powermeter.SHARED_PATH, help="read readings from power-meter-collector shared memory")
+	parser.add_argument("-H", "--history", metavar="SECONDS", type=float, default=60, help="history to keep")
+	parser.add_argument("-r", "--rate", metavar="HZ", type=float, default=1, help="expected reading rate (from all meters)")
 	args = parser.parse_args()
 
 	logging.basicConfig(level=args.debug, format="%(asctime)s.%(msecs)03d  %(levelname)5s  %(message)s", datefmt="%F %T")
 
-	receive_loop(args.meter, args.source)
+	receive_loop(args.meter, args.source, args.collector, timedelta(seconds=args.history), args.rate, args.shared)
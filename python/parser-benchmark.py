@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+#
+# power-meter - Arduino Power Meter Modbus Client
+# Copyright 2026  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+import argparse
+import powermeter
+import timeit
+import yaml
+
+DATAGRAMS = {
+	"RI-D19-80-C": b'meter: {model: "RI-D19-80-C",serialNumber: "123456789012",reading: {voltage: 2471.0e-1,current: 3.0e-1,frequency: 500.0e-1,activePower: 81.0,reactivePower: 28.0,apparentPower: 90.0,powerFactor: 1000.0e-1,temperature: 31.0,activeEnergy: 88.0e-2,reactiveEnergy: 12.0e-2}}\ntimestamp: 1700000000',
+	"PZEM-004T-100A": b'meter: {model: "PZEM-004T-100A",serialNumber: "1234567890",reading: {voltage: 2468.0e-1,current: 1788.0e-3,frequency: 499.0e-1,activePower: 2485.0e-1,powerFactor: 56.0e-2,activeEnergy: 2875.0e-3}}\ntimestamp: 1700000000.123456',
+}
+
+def benchmark(name, function, data, duration):
+	count = 1
+	while True:
+		elapsed = timeit.timeit(lambda: function(data), number=count)
+		if elapsed >= duration:
+			break
+		count *= 2
+
+	print("{0:>16}: {1:>10.0f} packets/s".format(name, count / elapsed))
+	return count / elapsed
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Power Meter reading parser benchmark")
+	parser.add_argument("-t", "--time", metavar="SECONDS", type=float, default=1, help="minimum time for each benchmark")
+	args = parser.parse_args()
+
+	for (model, data) in DATAGRAMS.items():
+		if powermeter.parse_documents(data) != list(yaml.safe_load_all(data)):
+			raise ValueError("Parsers disagree on " + model)
+
+		print(model)
+		fast = benchmark("parse_documents", powermeter.parse_documents, data, args.time)
+		slow = benchmark("yaml.safe_load", yaml.safe_load, data, args.time)
+		print("{0:>16}: {1:>10.1f}×".format("speedup", fast / slow))
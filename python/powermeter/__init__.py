@@ -1,5 +1,5 @@
 # power-meter - Arduino Power Meter Modbus Client
-# Copyright 2017,2025  Simon Arlott
+# Copyright 2017,2025-2026  Simon Arlott
 #
 # This program is free software: you can redistribute it and/or modify
 # it under the terms of the GNU General Public License as published by
@@ -16,11 +16,17 @@
 
 from collections import OrderedDict
 from datetime import datetime, timedelta
+from math import ceil, isnan
+import fcntl
 import logging
+import mmap
+import os
 import pytz
+import re
+import selectors
 import socket
 import struct
-import tzlocal
+import time
 import yaml
 
 
@@ -32,48 +38,326 @@ IPV4_HLEN = 20;
 UDP_HLEN = 8;
 MAX_LENGTH = ETH_DATA_LEN - IPV4_HLEN - UDP_HLEN
 
+# Binary frames (see arduino/src/BinaryFrame.hpp)
+FRAME_DELIMITER = b"\x00"
+FRAME_VERSION = 1
+FRAME_VERSION_BUS = 2
+FRAME_HEADER = struct.Struct("<BH")
+FRAME_BUS = struct.Struct("<BB")
+FRAME_BITMAPS = struct.Struct("<HH")
+FRAME_VALUE = struct.Struct("<bI")
+FRAME_CRC = struct.Struct("<H")
+
+# Binary datagrams start with a zero byte (which can't be the start of
+# a YAML document) followed by the timestamp in microseconds (or zero)
+# and then the decoded frame
+DATAGRAM_MARKER = b"\x00"
+DATAGRAM_TIMESTAMP = struct.Struct("<Q")
+
+# Readings from power-meter-collector are prefixed with the sender's IPv4 address
+COLLECTOR_PATH = "/run/power-meter-collector"
+COLLECTOR_SOURCE_LEN = 4
+
+# Shared memory published by power-meter-collector (see linux/src/SharedReadings.hpp)
+SHARED_PATH = "/dev/shm/power-meter-collector"
+SHARED_MAGIC = b"PMSHMEM1"
+SHARED_HEADER = struct.Struct("<8sIIIIIIQ")
+SHARED_ENTRY = struct.Struct("<QII")
+
+# Energy spool file: a header page followed by a ring of fixed size records
+# in the same format as the energy queue messages (reactive energy is NaN
+# when the meter doesn't have it)
+SPOOL_MAGIC = b"PMSPOOL1"
+SPOOL_HEADER = struct.Struct("=8sIIQQQ")
+SPOOL_HEADER_LEN = mmap.PAGESIZE
+SPOOL_RECORD = struct.Struct("=Qdd")
+SPOOL_CAPACITY = 1024 * 1024
+
+# The exact output of PowerMeter::printTo() (and serial-transmitter.py),
+# anything else is parsed as YAML
+_VALUE = rb"[A-Za-z]+: -?[0-9]+\.0(?:e-[0-9]+)?"
+_DOCUMENT_RE = re.compile(rb"meter: \{model: \"([^\"\\]*)\"(?:,serialNumber: \"([^\"\\]*)\")?(?:,bus: ([0-9]+),address: ([0-9]+))?,reading: \{((?:" + _VALUE + rb")(?:," + _VALUE + rb")*)?\}\}(?:\r?\ntimestamp: ([0-9]+)(?:\.([0-9]+))?)?\s*")
+_VALUE_RE = re.compile(rb"([A-Za-z]+): (-?[0-9]+)\.0(?:e(-[0-9]+))?")
+_DOCUMENT_SEPARATOR_RE = re.compile(rb"\r?\n---\r?\n")
+
 
 _PowerMeter__log = logging.getLogger("powermeter")
 
 class PowerMeter:
-	def __init__(self, serial_numbers=None, ip4_sources=None, always_yield=False):
+	def __init__(self, serial_numbers=None, ip4_sources=None, always_yield=False, collector=None, shared=None):
 		self.serial_numbers = serial_numbers
 		self.ip4_sources = ip4_sources
+		self.collector = collector
+		self.shared = None
+		self.always_yield = always_yield
 
-		ai = socket.getaddrinfo(IP4_GROUP, PORT, socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP, socket.AI_NUMERICHOST | socket.AI_NUMERICSERV)[0]
-		self.s = socket.socket(*ai[0:3])
-		self.s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
-		self.s.bind((IP4_GROUP, PORT))
+		if shared:
+			self.shared = SharedReadings(shared)
+			return
 
-		mreq = socket.inet_pton(ai[0], ai[4][0]) + struct.pack('=I', socket.INADDR_ANY)
-		self.s.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+		if collector:
+			self.s = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+			self.s.connect(collector)
+			if always_yield:
+				self.s.setblocking(False)
+			return
 
+		self.s = multicast_socket()
 		if always_yield:
 			self.s.setblocking(False)
 
+	def fileno(self):
+		"""File descriptor that is readable when there are readings, for use with an event loop (None for shared memory)"""
+		return None if self.shared else self.s.fileno()
+
+	def wait(self, timeout=None):
+		"""Wait for readings (timeout in seconds, or None to wait indefinitely), returns True if there may be some"""
+		if self.shared:
+			return self.shared.wait(timeout)
+
+		if not hasattr(self, "selector"):
+			self.selector = selectors.DefaultSelector()
+			self.selector.register(self.s, selectors.EVENT_READ)
+		return bool(self.selector.select(timeout))
+
+	def poll(self, timeout=None):
+		"""Readings received within the timeout (in seconds, or None to wait indefinitely)
+
+		Waits until a datagram is received and then returns the readings
+		from it and from any other datagrams that have already been received.
+		"""
+		readings = []
+		if self.wait(timeout):
+			try:
+				while True:
+					readings.extend(self.__receive(False))
+			except BlockingIOError:
+				pass
+		return readings
+
+	def __receive(self, block):
+		"""Receive one datagram, returning its readings (or raising BlockingIOError)"""
+		if self.shared:
+			if block:
+				self.shared.wait()
+			data = self.shared.receive()
+			if data is None:
+				raise BlockingIOError
+			sender = (socket.inet_ntoa(data[:COLLECTOR_SOURCE_LEN]),)
+			data = data[COLLECTOR_SOURCE_LEN:]
+		else:
+			(data, sender) = self.s.recvfrom(MAX_LENGTH, 0 if block else socket.MSG_DONTWAIT)
+
+		if self.collector:
+			if not data:
+				raise ConnectionResetError("Collector closed the connection")
+			sender = (socket.inet_ntoa(data[:COLLECTOR_SOURCE_LEN]),)
+			data = data[COLLECTOR_SOURCE_LEN:]
+		__log.debug(": ".join((sender[0], data.decode("utf-8", "replace"))))
+
+		if data.startswith(DATAGRAM_MARKER):
+			try:
+				documents = [unpack_datagram(data)]
+			except ValueError as e:
+				__log.debug(": ".join((sender[0], str(e))))
+				return []
+		else:
+			try:
+				documents = parse_documents(data)
+			except yaml.YAMLError as e:
+				return []
+
+		if self.ip4_sources and sender[0] not in self.ip4_sources:
+			return []
+
+		readings = []
+		for data in documents:
+			if not isinstance(data, dict):
+				continue
+
+			serial_number = data.get("meter", {}).get("serialNumber", None)
+			if serial_number and (not self.serial_numbers or serial_number in self.serial_numbers):
+				reading = data.get("meter", {}).get("reading", {})
+				if reading:
+					ts = data.get("timestamp")
+					if ts:
+						ts = pytz.utc.localize(datetime.utcfromtimestamp(ts))
+					readings.append(Reading(serial_number, data["meter"]["reading"], ts))
+		return readings
+
 	@property
 	def readings(self):
 		while True:
 			try:
-				(data, sender) = self.s.recvfrom(MAX_LENGTH)
-				__log.debug(": ".join((sender[0], data.decode("utf-8", "replace"))))
+				for reading in self.__receive(not self.always_yield):
+					yield reading
+			except BlockingIOError:
+				if self.always_yield:
+					yield None
 
-				try:
-					data = yaml.safe_load(data)
-				except yaml.YAMLError as e:
-					continue
 
-				serial_number = data.get("meter", {}).get("serialNumber", None)
-				if not self.ip4_sources or sender[0] in self.ip4_sources:
-					if serial_number and (not self.serial_numbers or serial_number in self.serial_numbers):
-						reading = data.get("meter", {}).get("reading", {})
-						if reading:
-							ts = data.get("timestamp")
-							if ts:
-								ts = pytz.utc.localize(datetime.utcfromtimestamp(ts))
-							yield Reading(serial_number, data["meter"]["reading"], ts)
-			except BlockingIOError:
-				yield None
+def multicast_socket():
+	"""Socket that receives datagrams sent to the multicast group"""
+	ai = socket.getaddrinfo(IP4_GROUP, PORT, socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP, socket.AI_NUMERICHOST | socket.AI_NUMERICSERV)[0]
+	s = socket.socket(*ai[0:3])
+	s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+	s.bind((IP4_GROUP, PORT))
+
+	mreq = socket.inet_pton(ai[0], ai[4][0]) + struct.pack('=I', socket.INADDR_ANY)
+	s.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+	return s
+
+def decimal_value(coefficient, exponent):
+	"""Convert a decimal to the nearest float (as YAML would) without rounding the intermediate values"""
+	if exponent < 0:
+		return coefficient / 10 ** -exponent
+	return float(coefficient * 10 ** exponent)
+
+def parse_document(data):
+	"""Parse one reading output by the firmware, returning None if it isn't in the expected format"""
+	match = _DOCUMENT_RE.fullmatch(data)
+	if not match:
+		return None
+
+	(model, serial_number, bus, address, values, seconds, fraction) = match.groups()
+	reading = {}
+	if values:
+		for (name, coefficient, exponent) in _VALUE_RE.findall(values):
+			reading[name.decode("ascii")] = decimal_value(int(coefficient), int(exponent) if exponent else 0)
+
+	meter = { "model": model.decode("utf-8", "replace"), "reading": reading }
+	if serial_number is not None:
+		meter["serialNumber"] = serial_number.decode("utf-8", "replace")
+	if bus is not None:
+		meter["bus"] = int(bus)
+		meter["address"] = int(address)
+
+	document = { "meter": meter }
+	if seconds is not None:
+		document["timestamp"] = decimal_value(int(seconds + fraction), -len(fraction)) if fraction else int(seconds)
+	return document
+
+def parse_documents(data):
+	"""Parse all of the readings in a datagram, falling back to YAML for unexpected input"""
+	documents = []
+	for document in _DOCUMENT_SEPARATOR_RE.split(data):
+		document = parse_document(document)
+		if document is None:
+			return list(yaml.safe_load_all(data))
+		documents.append(document)
+	return documents
+
+def crc16(data):
+	"""CRC-16/MODBUS"""
+	crc = 0xFFFF
+	for byte in data:
+		crc ^= byte
+		for i in range(8):
+			if crc & 1:
+				crc = (crc >> 1) ^ 0xA001
+			else:
+				crc >>= 1
+	return crc
+
+def cobs_decode(data):
+	output = bytearray()
+	pos = 0
+
+	while pos < len(data):
+		code = data[pos]
+		if code == 0 or pos + code > len(data):
+			raise ValueError("Invalid COBS block at {0}".format(pos))
+
+		output += data[pos + 1:pos + code]
+		pos += code
+		if code < 0xFF and pos < len(data):
+			output.append(0)
+
+	return bytes(output)
+
+def decode_frame(frame):
+	"""Decode a frame (without COBS encoding) into a dict matching the YAML output"""
+	if len(frame) < FRAME_HEADER.size + FRAME_CRC.size:
+		raise ValueError("Frame too short ({0} bytes)".format(len(frame)))
+
+	(crc,) = FRAME_CRC.unpack_from(frame, len(frame) - FRAME_CRC.size)
+	if crc != crc16(frame[:-FRAME_CRC.size]):
+		raise ValueError("Frame CRC mismatch")
+
+	try:
+		(version, sequence) = FRAME_HEADER.unpack_from(frame, 0)
+		if version not in (FRAME_VERSION, FRAME_VERSION_BUS):
+			raise ValueError("Unsupported frame version {0}".format(version))
+		pos = FRAME_HEADER.size
+
+		strings = []
+		for i in range(2):
+			length = frame[pos]
+			strings.append(frame[pos + 1:pos + 1 + length].decode("utf-8", "replace"))
+			pos += 1 + length
+		(model, serial_number) = strings
+
+		if version == FRAME_VERSION_BUS:
+			(bus, address) = FRAME_BUS.unpack_from(frame, pos)
+			pos += FRAME_BUS.size
+
+		(present, sign) = FRAME_BITMAPS.unpack_from(frame, pos)
+		pos += FRAME_BITMAPS.size
+
+		reading = {}
+		for (i, name) in enumerate(_Reading__fields):
+			if present & (1 << i):
+				(exponent, coefficient) = FRAME_VALUE.unpack_from(frame, pos)
+				pos += FRAME_VALUE.size
+				if sign & (1 << i) and coefficient & 0x80000000:
+					coefficient -= 0x100000000
+				reading[name] = float("{0}e{1}".format(coefficient, exponent))
+	except (IndexError, struct.error):
+		raise ValueError("Frame truncated")
+
+	meter = { "model": model, "sequence": sequence, "reading": reading }
+	if serial_number:
+		meter["serialNumber"] = serial_number
+	if version == FRAME_VERSION_BUS:
+		meter["bus"] = bus
+		meter["address"] = address
+	return { "meter": meter }
+
+def encode_frame(model, serial_number, sequence, reading, bus=None, address=None):
+	"""Encode a frame (without COBS encoding) from a dict of (coefficient, exponent) values"""
+	present = 0
+	sign = 0
+	values = b""
+	for (i, name) in enumerate(_Reading__fields):
+		if name in reading:
+			(coefficient, exponent) = reading[name]
+			present |= 1 << i
+			if coefficient < 0:
+				sign |= 1 << i
+			values += FRAME_VALUE.pack(exponent, coefficient & 0xFFFFFFFF)
+
+	frame = FRAME_HEADER.pack(FRAME_VERSION if bus is None else FRAME_VERSION_BUS, sequence & 0xFFFF)
+	for string in (model, serial_number or ""):
+		string = string.encode("utf-8")
+		frame += bytes((len(string),)) + string
+	if bus is not None:
+		frame += FRAME_BUS.pack(bus, address)
+	frame += FRAME_BITMAPS.pack(present, sign) + values
+	return frame + FRAME_CRC.pack(crc16(frame))
+
+def pack_datagram(frame, timestamp=None):
+	"""Create a binary datagram from a decoded frame and a timestamp in seconds"""
+	return DATAGRAM_MARKER + DATAGRAM_TIMESTAMP.pack(round(timestamp * 1000000) if timestamp else 0) + frame
+
+def unpack_datagram(data):
+	if len(data) < len(DATAGRAM_MARKER) + DATAGRAM_TIMESTAMP.size:
+		raise ValueError("Datagram too short ({0} bytes)".format(len(data)))
+
+	(ts,) = DATAGRAM_TIMESTAMP.unpack_from(data, len(DATAGRAM_MARKER))
+	data = decode_frame(data[len(DATAGRAM_MARKER) + DATAGRAM_TIMESTAMP.size:])
+	if ts:
+		data["timestamp"] = ts / 1000000
+	return data
 
 
 _Reading__fields = OrderedDict([
@@ -129,47 +413,301 @@ class Reading:
 		return ", ".join(["{0}={1}".format(k, v) for (k,v) in fields.items()])
 
 
+class SharedReadings:
+	"""Read-only access to the readings published by power-meter-collector in shared memory
+
+	Each entry is a collector message (the sender's IPv4 address followed
+	by a binary datagram). The sequence number of an entry is odd while it
+	is being written and changes on every write, so entries are copied and
+	then the sequence number is checked again.
+	"""
+
+	POLL_INTERVAL = 0.05
+
+	def __init__(self, path=SHARED_PATH):
+		self.path = path
+		self.lost = 0
+		self.__open()
+		self.pos = self.head
+
+	def __open(self):
+		with open(self.path, "rb") as f:
+			self.inode = os.fstat(f.fileno()).st_ino
+			self.map = mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ)
+
+		(magic, header_size, self.entry_size, self.slots, self.ring_size, _, _, _) = SHARED_HEADER.unpack_from(self.map, 0)
+		if magic != SHARED_MAGIC:
+			raise ValueError("{0} is not a power-meter-collector shared memory region".format(self.path))
+		self.slots_offset = header_size
+		self.ring_offset = header_size + self.slots * self.entry_size
+		self.counters = memoryview(self.map)[:SHARED_HEADER.size].cast("I")
+		self.head_value = memoryview(self.map)[SHARED_HEADER.size - 8:SHARED_HEADER.size].cast("Q")
+
+	@property
+	def meters(self):
+		return self.counters[6]
+
+	@property
+	def head(self):
+		return self.head_value[0]
+
+	def __read(self, offset, sequence=None):
+		"""Copy an entry, returns None if it changed or doesn't have the expected sequence number"""
+		(before, length, _) = SHARED_ENTRY.unpack_from(self.map, offset)
+		if before % 2 or (sequence is not None and before != sequence):
+			return None
+
+		data = self.map[offset + SHARED_ENTRY.size:offset + SHARED_ENTRY.size + min(length, self.entry_size - SHARED_ENTRY.size)]
+		(after, _, _) = SHARED_ENTRY.unpack_from(self.map, offset)
+		return data if after == before else None
+
+	def latest(self):
+		"""Latest message from each meter"""
+		messages = []
+		for i in range(self.meters):
+			for attempt in range(100):
+				data = self.__read(self.slots_offset + i * self.entry_size)
+				if data is not None:
+					messages.append(data)
+					break
+		return messages
+
+	def wait(self, timeout=None):
+		"""Wait until there is a message in the ring (timeout in seconds, or None to wait indefinitely)"""
+		deadline = None if timeout is None else time.monotonic() + timeout
+
+		while self.pos >= self.head:
+			# The collector creates a new region when it restarts
+			try:
+				if os.stat(self.path).st_ino != self.inode:
+					self.counters.release()
+					self.head_value.release()
+					self.map.close()
+					self.__open()
+					self.pos = 0
+					continue
+			except FileNotFoundError:
+				pass
+
+			if deadline is not None and time.monotonic() >= deadline:
+				return False
+			time.sleep(self.POLL_INTERVAL if deadline is None else max(0, min(self.POLL_INTERVAL, deadline - time.monotonic())))
+
+		return True
+
+	def receive(self):
+		"""Next message from the ring, or None if there isn't one"""
+		while self.pos < self.head:
+			head = self.head
+			if head - self.pos > self.ring_size:
+				self.lost += head - self.pos - self.ring_size
+				self.pos = head - self.ring_size
+
+			pos = self.pos
+			self.pos += 1
+			data = self.__read(self.ring_offset + (pos % self.ring_size) * self.entry_size, pos * 2 + 2)
+			if data is not None:
+				return data
+			self.lost += 1
+
+		return None
+
+class Spool:
+	"""Durable memory-mapped ring of energy readings with one writer and one reader
+
+	The header contains the capacity and the total number of records that
+	have been written and read. Each position is only updated by its owner,
+	after the records it covers have been written (by the writer) or stored
+	elsewhere (by the reader), so the contents survive either process
+	restarting. The writer flushes each record to disk before updating its
+	position.
+	"""
+
+	WRITER = "writer"
+	READER = "reader"
+
+	# Offsets of the positions in the header, and of the role locks (the
+	# magic is locked during initialisation)
+	__WRITE_POS = 24
+	__READ_POS = 32
+	__LOCK_OFFSET = { WRITER: __WRITE_POS, READER: __READ_POS }
+
+	def __init__(self, filename, role, capacity=SPOOL_CAPACITY):
+		self.role = role
+		self.fd = os.open(filename, os.O_RDWR | os.O_CREAT, 0o640)
+		try:
+			fcntl.lockf(self.fd, fcntl.LOCK_EX, len(SPOOL_MAGIC), 0)
+			try:
+				if os.fstat(self.fd).st_size == 0:
+					os.ftruncate(self.fd, SPOOL_HEADER_LEN + capacity * SPOOL_RECORD.size)
+					os.pwrite(self.fd, SPOOL_HEADER.pack(SPOOL_MAGIC, SPOOL_RECORD.size, 0, capacity, 0, 0), 0)
+					os.fsync(self.fd)
+
+				(magic, record_size, _, self.capacity, _, _) = SPOOL_HEADER.unpack(os.pread(self.fd, SPOOL_HEADER.size, 0))
+				if magic != SPOOL_MAGIC or record_size != SPOOL_RECORD.size:
+					raise ValueError("{0} is not an energy spool file".format(filename))
+				if os.fstat(self.fd).st_size < SPOOL_HEADER_LEN + self.capacity * SPOOL_RECORD.size:
+					raise ValueError("{0} is truncated".format(filename))
+			finally:
+				fcntl.lockf(self.fd, fcntl.LOCK_UN, len(SPOOL_MAGIC), 0)
+
+			# Only one writer and one reader
+			fcntl.lockf(self.fd, fcntl.LOCK_EX | fcntl.LOCK_NB, 8, self.__LOCK_OFFSET[role])
+
+			self.map = mmap.mmap(self.fd, SPOOL_HEADER_LEN + self.capacity * SPOOL_RECORD.size)
+			self.positions = memoryview(self.map)[self.__WRITE_POS:self.__READ_POS + 8].cast("Q")
+		except:
+			os.close(self.fd)
+			raise
+
+	@property
+	def write_pos(self):
+		return self.positions[0]
+
+	@property
+	def read_pos(self):
+		return self.positions[1]
+
+	def __len__(self):
+		"""Number of records that have not been read"""
+		return self.write_pos - self.read_pos
+
+	def append(self, ts, active_energy, reactive_energy=None):
+		"""Write a record, returns False if the spool is full"""
+		pos = self.write_pos
+		if pos - self.read_pos >= self.capacity:
+			return False
+
+		offset = SPOOL_HEADER_LEN + (pos % self.capacity) * SPOOL_RECORD.size
+		SPOOL_RECORD.pack_into(self.map, offset, ts, active_energy, float("nan") if reactive_energy is None else reactive_energy)
+
+		start = offset - offset % mmap.PAGESIZE
+		self.map.flush(start, offset + SPOOL_RECORD.size - start)
+		self.positions[0] = pos + 1
+		self.map.flush(0, SPOOL_HEADER_LEN)
+		return True
+
+	def read(self, count):
+		"""Unread records (up to count) as (ts, active_energy, reactive_energy), without consuming them"""
+		pos = self.read_pos
+		count = min(count, self.write_pos - pos)
+		records = []
+
+		for i in range(pos, pos + count):
+			(ts, active_energy, reactive_energy) = SPOOL_RECORD.unpack_from(self.map, SPOOL_HEADER_LEN + (i % self.capacity) * SPOOL_RECORD.size)
+			records.append((ts, active_energy, None if isnan(reactive_energy) else reactive_energy))
+
+		return records
+
+	def consume(self, count):
+		"""Mark records as read, after they have been stored"""
+		self.positions[1] = self.read_pos + min(count, len(self))
+		self.map.flush(0, SPOOL_HEADER_LEN)
+
+	def close(self):
+		self.positions.release()
+		self.map.close()
+		os.close(self.fd)
+
+
 try:
 	import numpy as np
 
 
 	_PowerMeterNumPy__fields = _Reading__fields
-	_PowerMeterNumPy__dtype = [("ts", "O")] + [(name, "float64") for name in _PowerMeterNumPy__fields.keys()]
-	_PowerMeterNumPy__localtz = tzlocal.get_localzone()
+	_PowerMeterNumPy__dtype = [("ts", "datetime64[ns]")] + [(name, "float64") for name in _PowerMeterNumPy__fields.keys()]
 
 	class PowerMeterNumPy(PowerMeter):
-		def __init__(self, serial_numbers=None, ip4_sources=None, always_yield=False, history=timedelta(seconds=60)):
-			super().__init__(serial_numbers, ip4_sources, always_yield)
+		"""Readings from all meters in a fixed-size circular buffer
+
+		Each row is written twice, at its position and at its position plus
+		the capacity, so that the most recent rows are always available as a
+		contiguous view without copying. Readings from different meters can
+		arrive slightly out of order so they're inserted in time order, which
+		usually only moves a few of the most recent rows.
+
+		The capacity is shared by all meters, so the rate is the expected
+		number of readings per second from all of them combined.
+
+		Timestamps are in UTC.
+		"""
+
+		def __init__(self, serial_numbers=None, ip4_sources=None, always_yield=False, history=timedelta(seconds=60), collector=None, rate=1, shared=None):
+			super().__init__(serial_numbers, ip4_sources, always_yield, collector, shared)
 
 			self.history = history
+			self.capacity = max(1, ceil(history.total_seconds() * rate))
+			self.data = np.empty(self.capacity * 2, dtype=__dtype).view(np.recarray)
+			self.data.ts = np.datetime64("NaT")
+			for name in __fields:
+				self.data[name] = np.nan
+			self.pos = 0
+			self.count = 0
+			self.newest = None
+			self.last = {}
+
+		def append(self, reading):
+			"""Insert a reading in time order, returns False if it's older than all of the buffered readings when the buffer is full"""
+			row = np.array([tuple([np.datetime64(reading.ts.replace(tzinfo=None), "ns")] + [np.nan if reading[name] is None else reading[name] for name in __fields])], dtype=__dtype)
+
+			end = self.pos + self.capacity
+			data = self.data[end - self.count:end]
+			insert = np.searchsorted(data.ts, row["ts"][0], side="right")
+			if insert == 0 and self.count == self.capacity:
+				return False
+
+			# Rewrite the new row and any newer rows after it, one position
+			# further on (overwriting the oldest row if the buffer is full)
+			rows = np.concatenate((row, np.asarray(data[insert:]).astype(__dtype)))
+			self.pos = (self.pos + 1) % self.capacity
+			self.count = min(self.count + 1, self.capacity)
+
+			index = (self.pos - len(rows) + np.arange(len(rows))) % self.capacity
+			self.data[index] = rows
+			self.data[index + self.capacity] = rows
+			return True
+
+		@property
+		def window(self):
+			"""View of the readings within the history period, oldest first"""
+			end = self.pos + self.capacity
+			data = self.data[end - self.count:end]
+			newest = np.datetime64(self.newest.replace(tzinfo=None), "ns")
+			start = np.searchsorted(data.ts, newest - np.timedelta64(self.history), side="left")
+			return data[start:]
+
+		def __add(self, reading):
+			# Readings from each meter must be in time order, but several
+			# meters can report in the same second (or slightly out of order)
+			last = self.last.get(reading.serialNumber)
+			if last is not None and reading.ts <= last:
+				return False
+			if self.newest is not None and reading.ts < self.newest - self.history:
+				return False
+			if not self.append(reading):
+				return False
+
+			self.last[reading.serialNumber] = reading.ts
+			self.newest = reading.ts if self.newest is None else max(self.newest, reading.ts)
+			return True
+
+		def poll(self, timeout=None):
+			"""Add the readings received within the timeout, returns the number added"""
+			return sum([1 for reading in super().poll(timeout) if self.__add(reading)])
 
 		@property
 		def readings(self):
-			data = None
-			last = None
+			readings = super().readings
 
 			while True:
-				reading = next(super().readings)
+				reading = next(readings)
 				if reading is not None:
-					now = reading.ts.replace(microsecond=0)
-					if now == last:
-						continue
-					last = now
-					local_now = now.astimezone(__localtz)
-
-					np_reading = tuple([local_now] + [reading[name] for name in __fields])
-					np_data = np.array([np_reading], dtype=__dtype)
-					if data is None:
-						data = np.array([tuple([(now - timedelta(seconds=i)).astimezone(__localtz)] + [None for name in __fields]) for i in range(self.history.seconds, 0, -1)], dtype=__dtype)
-					data = np.concatenate((data, np_data))
-
-					while data[["ts"]][0][0] < now - self.history:
-						data = np.delete(data, 0, 0)
-
-				if data is None:
+					self.__add(reading)
+
+				if self.count == 0:
 					yield None
 				else:
-					yield np.rec.array(data)
+					yield self.window
 
 except ImportError:
 	pass
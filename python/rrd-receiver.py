@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 #
 # power-meter - Arduino Power Meter Modbus Client
-# Copyright 2017,2025  Simon Arlott
+# Copyright 2017,2025-2026  Simon Arlott
 #
 # This program is free software: you can redistribute it and/or modify
 # it under the terms of the GNU General Public License as published by
@@ -24,17 +24,25 @@ import os
 import powermeter
 import re
 import rrdtool
+import socket
 import sys
 import systemd.daemon
+import threading
+import time
 import traceback
 
 log = logging.getLogger("readings")
 
+FLUSH_INTERVAL = 1
+QUEUE_LENGTH = 3600
+RRDCACHED_PORT = 42217
+
 
 class RRD:
-	def __init__(self, directory, filename):
-		self.filename_supply = os.path.join(directory, re.sub("[^A-Za-z0-9 ]", "_", filename) + ",supply.rrd")
-		self.filename_load = os.path.join(directory, re.sub("[^A-Za-z0-9 ]", "_", filename) + ",load.rrd")
+	def __init__(self, directory, filename, queue):
+		self.queue = queue
+		self.filename_supply = os.path.abspath(os.path.join(directory, re.sub("[^A-Za-z0-9 ]", "_", filename) + ",supply.rrd"))
+		self.filename_load = os.path.abspath(os.path.join(directory, re.sub("[^A-Za-z0-9 ]", "_", filename) + ",load.rrd"))
 
 		if not os.path.exists(self.filename_supply):
 			rrdtool.create(self.filename_supply,
@@ -86,37 +94,191 @@ class RRD:
 				math.sqrt(abs(reading["apparentPower"] ** 2 - reading["activePower"] ** 2)), 1
 			)
 
-		__update(self.filename_supply, reading, ["voltage", "frequency", "temperature"])
-		__update(self.filename_load, reading, ["current", "activePower", "reactivePower", "apparentPower", "powerFactor"])
-		systemd.daemon.notify("STATUS=Updated reading at " + str(reading.ts))
-
-def _RRD__update(filename, reading, fields):
-	template = ":".join(fields)
-	data = ":".join([str(x) for x in [int(reading.ts.timestamp())] + [reading[field] if reading[field] is not None else "U" for field in fields]])
-	log.info("Update %s: %s = %s", filename, template, data)
-	try:
-		rrdtool.update(filename, "-s", "-t", template, data)
-	except KeyboardInterrupt:
-		raise
-	except SystemExit:
-		raise
-	except:
-		for line in traceback.format_exc().split("\n"):
-			log.error(line)
-
-		systemd.daemon.notify("STATUS=Update ({0}: {1} = {2}) error: {3}".format(filename, template, data, sys.exc_info()[1]))
-		raise
-
-
-def receive_loop(output_directory, serial_numbers=None, ip4_numbers=None):
-	meter = powermeter.PowerMeter(serial_numbers, ip4_numbers)
+		# Fields must be in the same order as the data sources (rrdcached
+		# does not support templates)
+		self.queue.add(self.filename_supply, reading, ["voltage", "frequency", "temperature"])
+		self.queue.add(self.filename_load, reading, ["current", "activePower", "reactivePower", "apparentPower", "powerFactor"])
+
+
+class UpdateQueue(threading.Thread):
+	"""Queue of pending updates for each file, written in batches
+
+	Updates are written directly with rrdtool or sent to rrdcached, from
+	a separate thread so that slow writes don't block receiving readings.
+	"""
+
+	def __init__(self, daemon_address=None):
+		super().__init__(daemon=True)
+		self.daemon_address = daemon_address
+		self.lock = threading.Lock()
+		self.queues = collections.OrderedDict()
+		self.timestamps = {}
+		self.dropped = 0
+		self.unacknowledged = set()
+		self.s = None
+		self.f = None
+
+	def add(self, filename, reading, fields):
+		# Updates must be at least one second after the previous update
+		ts = int(reading.ts.timestamp())
+		if ts <= self.timestamps.get(filename, 0):
+			return
+		self.timestamps[filename] = ts
+
+		data = ":".join([str(x) for x in [ts] + [reading[field] if reading[field] is not None else "U" for field in fields]])
+		log.info("Queue %s: %s = %s", filename, ":".join(fields), data)
+
+		with self.lock:
+			if filename not in self.queues:
+				self.queues[filename] = (fields, collections.deque())
+			queue = self.queues[filename][1]
+			if len(queue) >= QUEUE_LENGTH:
+				queue.popleft()
+				self.dropped += 1
+			queue.append(data)
+
+	def run(self):
+		while True:
+			time.sleep(FLUSH_INTERVAL)
+
+			# Values are removed from the queues while they're written and
+			# put back if the write fails
+			with self.lock:
+				pending = [(filename, fields, list(queue)) for (filename, (fields, queue)) in self.queues.items() if queue]
+				for (fields, queue) in self.queues.values():
+					queue.clear()
+
+			if not pending:
+				continue
+
+			count = sum([len(values) for (filename, fields, values) in pending])
+			last = pending[-1][2][-1].split(":")[0]
+			try:
+				if self.daemon_address:
+					if not self.s:
+						self.s = __connect(self.daemon_address)
+						self.f = self.s.makefile("r", encoding="utf-8")
+					__flush_rrdcached(self, pending)
+				else:
+					__flush_rrdtool(self, pending)
+
+				with self.lock:
+					dropped = self.dropped
+				systemd.daemon.notify("STATUS=Updated {0} values in {1} files up to {2}{3}".format(
+					count, len(pending), last, ", dropped {0}".format(dropped) if dropped else ""))
+			except KeyboardInterrupt:
+				raise
+			except SystemExit:
+				raise
+			except:
+				for line in traceback.format_exc().split("\n"):
+					log.error(line)
+
+				systemd.daemon.notify("STATUS=Update error: {0}".format(sys.exc_info()[1]))
+				self.__requeue(pending)
+				if self.s:
+					self.s.close()
+				self.s = None
+				self.f = None
+
+	def __requeue(self, pending):
+		"""Put values that weren't written back at the front of their queues
+
+		The flush functions remove values from pending once they have been
+		written (or rejected), so only values without a result are requeued.
+		"""
+		with self.lock:
+			for (filename, fields, values) in pending:
+				queue = self.queues[filename][1]
+				queue.extendleft(reversed(values))
+				while len(queue) > QUEUE_LENGTH:
+					queue.popleft()
+					self.dropped += 1
+
+def _UpdateQueue__flush_rrdtool(self, pending):
+	for (filename, fields, values) in pending:
+		log.info("Update %s: %s = %s", filename, ":".join(fields), " ".join(values))
+		try:
+			rrdtool.update(filename, "-s", "-t", ":".join(fields), *values)
+		except rrdtool.OperationalError as e:
+			log.error("Update %s: %s", filename, e)
+
+			# Write the values individually so that only the invalid ones
+			# are lost (values already written are skipped)
+			for value in values:
+				try:
+					rrdtool.update(filename, "-s", "-t", ":".join(fields), value)
+				except rrdtool.OperationalError as e:
+					log.error("Update %s: %s = %s: %s", filename, ":".join(fields), value, e)
+					with self.lock:
+						self.dropped += 1
+		values.clear()
+
+def _UpdateQueue__connect(address):
+	if address.startswith("unix:") or address.startswith("/"):
+		s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+		s.connect(address[5:] if address.startswith("unix:") else address)
+	else:
+		(host, sep, port) = address.rpartition(":")
+		if not sep or "]" in port:
+			(host, port) = (address, RRDCACHED_PORT)
+		s = socket.create_connection((host.strip("[]"), int(port)))
+	return s
+
+def _UpdateQueue__flush_rrdcached(self, pending):
+	def response():
+		line = self.f.readline()
+		if not line:
+			raise ConnectionResetError("rrdcached closed the connection")
+		(status, message) = line.rstrip("\n").split(" ", 1)
+		lines = [self.f.readline().rstrip("\n") for i in range(max(0, int(status)))]
+		if int(status) < 0:
+			raise IOError("rrdcached: " + message)
+		return lines
+
+	# Each value is a separate command so that errors are reported for
+	# each value and don't stop the file's other values from being written
+	commands = []
+	for (filename, fields, values) in pending:
+		escaped = re.sub(r"([\\ ])", r"\\\1", filename)
+		for value in values:
+			commands.append((filename, value, "UPDATE {0} {1}\n".format(escaped, value)))
+
+	# Values sent before the connection was lost may have been written
+	# already, so errors when they're sent again aren't counted as drops
+	resent = set(self.unacknowledged)
+
+	self.s.sendall(b"BATCH\n")
+	response()
+	self.s.sendall("".join([command for (filename, value, command) in commands] + [".\n"]).encode("utf-8"))
+	self.unacknowledged |= {(filename, value) for (filename, value, command) in commands}
+	errors = response()
+	self.unacknowledged = set()
+
+	for (filename, fields, values) in pending:
+		values.clear()
+
+	for line in errors:
+		(number, message) = line.split(" ", 1)
+		(filename, value, command) = commands[int(number) - 1]
+		if (filename, value) in resent:
+			log.info("Update %s: %s: %s (sent before reconnecting)", filename, value, message)
+		else:
+			log.error("Update %s: %s: %s", filename, value, message)
+			with self.lock:
+				self.dropped += 1
+
+def receive_loop(output_directory, serial_numbers=None, ip4_numbers=None, collector=None, daemon_address=None, shared=None):
+	meter = powermeter.PowerMeter(serial_numbers, ip4_numbers, collector=collector, shared=shared)
+	queue = UpdateQueue(daemon_address)
+	queue.start()
 	rrds = {}
 
 	systemd.daemon.notify("READY=1")
 
 	for reading in meter.readings:
 		if reading.serialNumber not in rrds:
-			rrds[reading.serialNumber] = RRD(output_directory, reading.serialNumber)
+			rrds[reading.serialNumber] = RRD(output_directory, reading.serialNumber, queue)
 		rrds[reading.serialNumber].update(reading)
 
 if __name__ == "__main__":
@@ -124,9 +286,12 @@ if __name__ == "__main__":
 	parser.add_argument("-v", "--verbose", action="store_const", default=logging.ERROR, const=logging.INFO, help="verbose mode")
 	parser.add_argument("-m", "--meter", metavar="SERIAL_NUMBER", type=str, action="append", help="filter power meter by serial number")
 	parser.add_argument("-s", "--source", metavar="IP_ADDRESS", type=str, action="append", help="filter power meter by IP address")
+	parser.add_argument("-c", "--collector", metavar="SOCKET", type=str, nargs="?", const=powermeter.COLLECTOR_PATH, help="receive readings from power-meter-collector")
+	parser.add_argument("-S", "--shared", metavar="PATH", type=str, nargs="?", const=powermeter.SHARED_PATH, help="read readings from power-meter-collector shared memory")
 	parser.add_argument("-o", "--output", metavar="DIRECTORY", type=str, default=".", help="output directory")
+	parser.add_argument("-d", "--daemon", metavar="ADDRESS", type=str, default=os.environ.get("RRDCACHED_ADDRESS"), help="send updates to rrdcached")
 	args = parser.parse_args()
 
 	logging.basicConfig(level=args.verbose, format="%(asctime)s.%(msecs)03d  %(levelname)5s  %(message)s", datefmt="%F %T")
 
-	receive_loop(args.output, args.meter, args.source)
+	receive_loop(args.output, args.meter, args.source, args.collector, args.daemon, args.shared)
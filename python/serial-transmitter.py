@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 #
 # power-meter - Arduino Power Meter Modbus Client
-# Copyright 2017  Simon Arlott
+# Copyright 2017,2026  Simon Arlott
 #
 # This program is free software: you can redistribute it and/or modify
 # it under the terms of the GNU General Public License as published by
@@ -30,19 +30,75 @@ import time
 
 log = logging.getLogger("readings")
 
-def transmit_loop(device, interface):
+TIOCGICOUNT = 0x545D
+SERIAL_ICOUNTER = struct.Struct("@20i")
+SERIAL_ICOUNTER_OVERRUN = 7
+SERIAL_ICOUNTER_BUF_OVERRUN = 10
+
+DOCUMENT_SEPARATOR = b"\n---\n"
+
+class Overruns:
+	"""Count receive overruns reported by the serial driver and by the transmitter itself,
+	and frames lost according to their sequence numbers"""
+
+	def __init__(self, fd):
+		self.fd = fd
+		self.supported = True
+		self.start = self.__driver()
+		self.local = 0
+		self.total = 0
+		self.sequence = None
+		self.lost = 0
+
+	def __driver(self):
+		if self.supported:
+			try:
+				counters = SERIAL_ICOUNTER.unpack(fcntl.ioctl(self.fd, TIOCGICOUNT, bytes(SERIAL_ICOUNTER.size)))
+				return counters[SERIAL_ICOUNTER_OVERRUN] + counters[SERIAL_ICOUNTER_BUF_OVERRUN]
+			except OSError:
+				self.supported = False
+		return 0
+
+	def check(self, local=0):
+		self.local += local
+		total = self.__driver() - self.start + self.local
+		if total != self.total:
+			log.warning("%d overruns", total)
+			self.__status(total)
+		self.total = total
+
+	def frame(self, sequence):
+		"""Check the sequence number of a frame for any missing frames"""
+		if self.sequence is not None:
+			missing = (sequence - self.sequence - 1) & 0xFFFF
+			if sequence == 0 and missing:
+				log.info("Sequence restarted after %d", self.sequence)
+			elif missing:
+				self.lost += missing
+				log.warning("%d frames lost", self.lost)
+				self.__status(self.total)
+		self.sequence = sequence
+
+	def __status(self, total):
+		status = "{0} overruns".format(total)
+		if self.lost:
+			status += ", {0} frames lost".format(self.lost)
+		systemd.daemon.notify("STATUS=" + status)
+
+def transmit_loop(device, interface, binary=False, all_lines=False):
 	# Wait for a new second before opening the device
 	now = time.time()
 	time.sleep(1 - (now - int(now)))
 
 	with serial.Serial(device, 115200) as input:
-		# Configure read() to block until a whole line is received
-		attrs = termios.tcgetattr(input.fd)
-		attrs[3] |= termios.ICANON
-		attrs[6][termios.VMIN] = 1
-		attrs[6][termios.VTIME] = 0
-		termios.tcsetattr(input.fd, termios.TCSAFLUSH, attrs)
-		fcntl.fcntl(input.fd, fcntl.F_SETFL, 1)
+		if not binary and not all_lines:
+			# Configure read() to block until a whole line is received
+			attrs = termios.tcgetattr(input.fd)
+			attrs[3] |= termios.ICANON
+			attrs[6][termios.VMIN] = 1
+			attrs[6][termios.VTIME] = 0
+			termios.tcsetattr(input.fd, termios.TCSAFLUSH, attrs)
+			fcntl.fcntl(input.fd, fcntl.F_SETFL, 1)
 
 		with socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP) as output:
 			output.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
@@ -55,25 +111,115 @@ def transmit_loop(device, interface):
 
 			systemd.daemon.notify("READY=1")
 
-			last = 0
-			while True:
-				# Extract the last line of any data read
-				line = list(filter(None, os.read(input.fd, 4096).replace(b"\r", b"").split(b"\n")))[-1]
+			if binary:
+				transmit_frames(input, output)
+			elif all_lines:
+				transmit_all_lines(input, output)
+			else:
+				transmit_lines(input, output)
+
+def transmit_lines(input, output):
+	last = 0
+	while True:
+		# Extract the last line of any data read
+		line = list(filter(None, os.read(input.fd, 4096).replace(b"\r", b"").split(b"\n")))[-1]
+
+		now = int(time.time())
+		if now != last:
+			output.sendto(line + b"\ntimestamp: " + str(now).encode("ascii"), (powermeter.IP4_GROUP, powermeter.PORT))
+		last = now
+
+		log.debug(line)
+
+def transmit_all_lines(input, output):
+	# pyserial opens the port non-blocking, so wait in read() for more data
+	os.set_blocking(input.fd, True)
+
+	overruns = Overruns(input.fd)
+	buffer = b""
+
+	while True:
+		buffer += os.read(input.fd, 4096)
+		now = time.clock_gettime(time.CLOCK_REALTIME)
+		timestamp = b"\ntimestamp: " + "{0:.6f}".format(now).encode("ascii")
+
+		# Forward every complete line, keeping any partial line for the next read
+		lines = buffer.replace(b"\r", b"").split(b"\n")
+		buffer = lines.pop()
+
+		# Combine lines read together into as few datagrams as possible
+		datagram = b""
+		for line in filter(None, lines):
+			log.debug(line)
+
+			if line.startswith(b"#"):
+				continue
+
+			document = line + timestamp
+			if datagram and len(datagram) + len(DOCUMENT_SEPARATOR) + len(document) > powermeter.MAX_LENGTH:
+				output.sendto(datagram, (powermeter.IP4_GROUP, powermeter.PORT))
+				datagram = b""
+
+			if datagram:
+				datagram += DOCUMENT_SEPARATOR
+			datagram += document
+
+		if datagram:
+			output.sendto(datagram, (powermeter.IP4_GROUP, powermeter.PORT))
+
+		if len(buffer) > powermeter.MAX_LENGTH:
+			log.debug("Discarding %d bytes without a line ending", len(buffer))
+			buffer = b""
+			overruns.check(1)
+		else:
+			overruns.check()
+
+def transmit_frames(input, output):
+	# pyserial opens the port non-blocking, so wait in read() for more data
+	os.set_blocking(input.fd, True)
+
+	overruns = Overruns(input.fd)
+	buffer = b""
+	errors = 0
+
+	while True:
+		buffer += os.read(input.fd, 4096)
+		now = time.clock_gettime(time.CLOCK_REALTIME)
+
+		# Forward every complete frame, keeping any partial frame for the next read
+		frames = buffer.split(powermeter.FRAME_DELIMITER)
+		buffer = frames.pop()
+
+		for frame in filter(None, frames):
+			try:
+				frame = powermeter.cobs_decode(frame)
+				data = powermeter.decode_frame(frame)
+			except ValueError as e:
+				errors += 1
+				log.debug("Invalid frame: %s (%d errors)", e, errors)
+				continue
+
+			overruns.frame(data["meter"]["sequence"])
 
-				now = int(time.time())
-				if now != last:
-					output.sendto(line + b"\ntimestamp: " + str(now).encode("ascii"), (powermeter.IP4_GROUP, powermeter.PORT))
-				last = now
+			output.sendto(powermeter.pack_datagram(frame, now), (powermeter.IP4_GROUP, powermeter.PORT))
+			log.debug(frame.hex())
 
-				log.debug(line)
+		if len(buffer) > powermeter.MAX_LENGTH:
+			log.debug("Discarding %d bytes without a frame delimiter", len(buffer))
+			buffer = b""
+			overruns.check(1)
+		else:
+			overruns.check()
 
 if __name__ == "__main__":
 	parser = argparse.ArgumentParser(description="Power Meter transmitter")
 	parser.add_argument("-d", "--debug", action="store_const", default=logging.INFO, const=logging.DEBUG, help="enable debug")
 	parser.add_argument("-l", "--line", metavar="DEVICE", type=str, required=True, help="serial device to open")
 	parser.add_argument("-i", "--interface", metavar="INTERFACE", type=str, required=True, help="network interface to use")
+	parser.add_argument("-b", "--binary", action="store_true", help="read binary frames instead of YAML lines")
+	parser.add_argument("-a", "--all", action="store_true", help="forward every line instead of one per second")
 	args = parser.parse_args()
 
 	logging.basicConfig(level=args.debug, format="%(asctime)s.%(msecs)03d  %(levelname)5s  %(message)s", datefmt="%F %T")
 
-	transmit_loop(args.line, args.interface)
+	transmit_loop(args.line, args.interface, args.binary, args.all)
@@ -0,0 +1,357 @@
+#!/usr/bin/env python3
+#
+# power-meter - Arduino Power Meter Modbus Client
+# Copyright 2026  Simon Arlott
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Capture datagrams from the multicast group, replay captures or generate
+# readings from any number of virtual meters, to load test the receivers.
+#
+# While sending, a PowerMeter receiver can be run in another process (with
+# --receive) to count the readings delivered. The host's UDP receive errors
+# are also reported, which include drops by any other local receivers.
+
+import argparse
+import logging
+import math
+import multiprocessing
+import powermeter
+import random
+import re
+import socket
+import struct
+import time
+import yaml
+
+log = logging.getLogger("traffic")
+
+# Capture file: the magic value followed by records containing the time the
+# datagram was received (in microseconds), the sender's IPv4 address, the
+# length of the datagram and then the datagram itself
+CAPTURE_MAGIC = b"PMCAPTR1"
+CAPTURE_RECORD = struct.Struct("<Q4sH")
+
+_TIMESTAMP_RE = re.compile(rb"(\ntimestamp: )[0-9]+(?:\.[0-9]+)?")
+
+class Receiver(multiprocessing.Process):
+	"""Count readings delivered to a PowerMeter receiver until stopped"""
+
+	def __init__(self, serial_numbers=None):
+		super().__init__(daemon=True)
+		self.serial_numbers = serial_numbers
+		self.ready = multiprocessing.Event()
+		self.stop = multiprocessing.Event()
+		self.count = multiprocessing.Value("Q", 0)
+
+	def run(self):
+		meter = powermeter.PowerMeter(self.serial_numbers)
+		self.ready.set()
+
+		count = 0
+		while not self.stop.is_set():
+			count += len(meter.poll(0.1))
+		count += len(meter.poll(0))
+		self.count.value = count
+
+	def finish(self):
+		# Allow time for the last datagrams to be processed
+		time.sleep(0.5)
+		self.stop.set()
+		self.join()
+		return self.count.value
+
+class UDPStatistics:
+	"""Host UDP statistics (receive errors include drops by every receiver)"""
+
+	def __init__(self):
+		self.start = self.__read()
+
+	def __read(self):
+		with open("/proc/net/snmp", "r") as f:
+			lines = [line.split() for line in f if line.startswith("Udp:")]
+		return dict(zip(lines[0][1:], map(int, lines[1][1:])))
+
+	def delta(self):
+		now = self.__read()
+		return { key: now[key] - self.start[key] for key in ("InDatagrams", "InErrors", "RcvbufErrors") }
+
+class Sender:
+	def __init__(self, interface=None):
+		self.s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+		self.s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
+		self.s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+
+		if interface:
+			mcast_if = (socket.inet_pton(socket.AF_INET, powermeter.IP4_GROUP)
+				+ struct.pack("!I", socket.INADDR_ANY)
+				+ struct.pack("@i", socket.if_nametoindex(interface)))
+			self.s.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, mcast_if)
+
+		self.datagrams = 0
+		self.readings = 0
+		self.errors = 0
+		self.late = 0
+
+	def wait(self, deadline):
+		"""Sleep until the deadline (monotonic time), counting sends that are behind schedule"""
+		delay = deadline - time.monotonic()
+		if delay > 0:
+			time.sleep(delay)
+		elif delay < -0.01:
+			self.late += 1
+
+	def send(self, data, readings):
+		try:
+			self.s.sendto(data, (powermeter.IP4_GROUP, powermeter.PORT))
+			self.datagrams += 1
+			self.readings += readings
+		except OSError as e:
+			self.errors += 1
+			log.debug("Send failed: %s", e)
+
+class VirtualMeter:
+	"""Readings that vary over time like a real meter with a changing load"""
+
+	def __init__(self, number, binary):
+		self.model = "RI-D19-80-C"
+		self.serial_number = "LOAD{0:08d}".format(number)
+		self.binary = binary
+		self.sequence = 0
+		self.voltage = random.uniform(235, 250)
+		self.frequency = random.uniform(49.95, 50.05)
+		self.current = random.uniform(0.2, 20)
+		self.power_factor = random.uniform(0.6, 1)
+		self.temperature = random.uniform(15, 35)
+		self.active_energy = random.uniform(0, 50000)
+		self.reactive_energy = self.active_energy * random.uniform(0, 0.2)
+		self.last = None
+
+	def update(self, now):
+		elapsed = now - self.last if self.last is not None else 0
+		self.last = now
+
+		self.voltage = min(max(self.voltage + random.gauss(0, 0.2), 220), 255)
+		self.frequency = min(max(self.frequency + random.gauss(0, 0.005), 49.8), 50.2)
+		self.current = min(max(self.current * random.lognormvariate(0, 0.05), 0.1), 80)
+		self.power_factor = min(max(self.power_factor + random.gauss(0, 0.01), 0.5), 1)
+
+		apparent = self.voltage * self.current
+		active = apparent * self.power_factor
+		reactive = math.sqrt(apparent ** 2 - active ** 2)
+		self.active_energy += active * elapsed / 3600000
+		self.reactive_energy += reactive * elapsed / 3600000
+		self.sequence += 1
+
+		return {
+			"voltage": (round(self.voltage * 10), -1),
+			"current": (round(self.current * 10), -1),
+			"frequency": (round(self.frequency * 10), -1),
+			"activePower": (round(active), 0),
+			"reactivePower": (round(reactive), 0),
+			"apparentPower": (round(apparent), 0),
+			"powerFactor": (round(self.power_factor * 1000), -1),
+			"temperature": (round(self.temperature), 0),
+			"activeEnergy": (round(self.active_energy * 100) % 10**10, -2),
+			"reactiveEnergy": (round(self.reactive_energy * 100) % 10**10, -2),
+		}
+
+	def datagram(self, now):
+		"""Datagram in the same format as serial-transmitter.py"""
+		reading = self.update(now)
+
+		if self.binary:
+			return powermeter.pack_datagram(powermeter.encode_frame(self.model, self.serial_number, self.sequence, reading), now)
+
+		values = ",".join("{0}: {1}.0{2}".format(name, coefficient, "e{0}".format(exponent) if exponent else "")
+			for (name, (coefficient, exponent)) in reading.items())
+		return 'meter: {{model: "{0}",serialNumber: "{1}",reading: {{{2}}}}}\ntimestamp: {3:.6f}'.format(
+			self.model, self.serial_number, values, now).encode("utf-8")
+
+def count_readings(data):
+	"""Number of readings in a datagram"""
+	try:
+		if data.startswith(powermeter.DATAGRAM_MARKER):
+			powermeter.unpack_datagram(data)
+			return 1
+		return len(powermeter.parse_documents(data))
+	except (ValueError, yaml.YAMLError):
+		return 0
+
+def retime(data, now):
+	"""Replace the timestamp in a datagram"""
+	if data.startswith(powermeter.DATAGRAM_MARKER):
+		return powermeter.pack_datagram(data[len(powermeter.DATAGRAM_MARKER) + powermeter.DATAGRAM_TIMESTAMP.size:], now)
+	return _TIMESTAMP_RE.sub(lambda match: match.group(1) + "{0:.6f}".format(now).encode("ascii"), data)
+
+def read_capture(filename):
+	records = []
+	with open(filename, "rb") as f:
+		if f.read(len(CAPTURE_MAGIC)) != CAPTURE_MAGIC:
+			raise ValueError("{0} is not a capture file".format(filename))
+
+		while True:
+			header = f.read(CAPTURE_RECORD.size)
+			if len(header) < CAPTURE_RECORD.size:
+				break
+
+			(ts, source, length) = CAPTURE_RECORD.unpack(header)
+			data = f.read(length)
+			if len(data) < length:
+				break
+			records.append((ts / 1000000, data))
+	return records
+
+def capture(filename, duration=None, count=None):
+	s = powermeter.multicast_socket()
+	captured = 0
+	size = 0
+
+	with open(filename, "wb") as f:
+		f.write(CAPTURE_MAGIC)
+		stop = time.monotonic() + duration if duration else None
+
+		try:
+			while count is None or captured < count:
+				if stop is not None:
+					timeout = stop - time.monotonic()
+					if timeout <= 0:
+						break
+					s.settimeout(timeout)
+
+				try:
+					(data, sender) = s.recvfrom(powermeter.MAX_LENGTH)
+				except socket.timeout:
+					break
+				ts = time.clock_gettime_ns(time.CLOCK_REALTIME) // 1000
+
+				f.write(CAPTURE_RECORD.pack(ts, socket.inet_aton(sender[0]), len(data)) + data)
+				captured += 1
+				size += len(data)
+		except KeyboardInterrupt:
+			pass
+
+	print("Captured {0} datagrams ({1} bytes)".format(captured, size))
+
+def replay(filename, speed, interface=None, receive=False, retime_readings=False, repeat=1):
+	records = [(ts, data, count_readings(data)) for (ts, data) in read_capture(filename)]
+	if not records:
+		raise ValueError("{0} is empty".format(filename))
+
+	sender = Sender(interface)
+	receiver = start_receiver(receive)
+	udp = UDPStatistics()
+	start = time.monotonic()
+
+	try:
+		offset = 0
+		for i in range(repeat):
+			first = records[0][0]
+			for (ts, data, readings) in records:
+				if speed:
+					sender.wait(start + (offset + ts - first) / speed)
+				if retime_readings:
+					data = retime(data, time.time())
+				sender.send(data, readings)
+
+			# Continue at the same rate for the next repetition
+			offset += records[-1][0] - first + (records[-1][0] - first) / max(len(records) - 1, 1)
+	except KeyboardInterrupt:
+		pass
+
+	report(sender, time.monotonic() - start, receiver, udp)
+
+def generate(meters, rate, duration, binary=False, interface=None, receive=False):
+	virtual_meters = [VirtualMeter(i, binary) for i in range(meters)]
+	sender = Sender(interface)
+	receiver = start_receiver(receive, [meter.serial_number for meter in virtual_meters])
+	udp = UDPStatistics()
+	start = time.monotonic()
+
+	# Spread the meters evenly over each period
+	period = 1 / rate
+	step = period / meters
+	try:
+		n = 0
+		while duration is None or n * period < duration:
+			for (i, meter) in enumerate(virtual_meters):
+				sender.wait(start + n * period + i * step)
+				sender.send(meter.datagram(time.time()), 1)
+			n += 1
+	except KeyboardInterrupt:
+		pass
+
+	report(sender, time.monotonic() - start, receiver, udp)
+
+def start_receiver(receive, serial_numbers=None):
+	if not receive:
+		return None
+
+	receiver = Receiver(serial_numbers)
+	receiver.start()
+	receiver.ready.wait()
+	return receiver
+
+def report(sender, elapsed, receiver, udp):
+	print("{0:>12}: {1} datagrams, {2} readings in {3:.3f}s ({4:.0f} readings/s)".format("sent",
+		sender.datagrams, sender.readings, elapsed, sender.readings / elapsed if elapsed else 0))
+	if sender.errors or sender.late:
+		print("{0:>12}: {1} send errors, {2} sends behind schedule".format("sender", sender.errors, sender.late))
+
+	if receiver:
+		delivered = receiver.finish()
+		print("{0:>12}: {1} readings ({2:.2%})".format("delivered", delivered, delivered / sender.readings if sender.readings else 0))
+
+	stats = udp.delta()
+	print("{0:>12}: {1} datagrams received, {2} errors ({3} receive buffer errors)".format("host UDP",
+		stats["InDatagrams"], stats["InErrors"], stats["RcvbufErrors"]))
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Power Meter traffic capture, replay and generator")
+	parser.add_argument("-d", "--debug", action="store_const", default=logging.INFO, const=logging.DEBUG, help="enable debug")
+	subparsers = parser.add_subparsers(dest="command", required=True)
+
+	capture_parser = subparsers.add_parser("capture", help="capture datagrams from the multicast group")
+	capture_parser.add_argument("filename", metavar="FILE", type=str, help="capture file to write")
+	capture_parser.add_argument("-t", "--time", metavar="SECONDS", type=float, help="stop after this time")
+	capture_parser.add_argument("-n", "--count", metavar="DATAGRAMS", type=int, help="stop after this number of datagrams")
+
+	replay_parser = subparsers.add_parser("replay", help="replay a capture file")
+	replay_parser.add_argument("filename", metavar="FILE", type=str, help="capture file to read")
+	replay_parser.add_argument("-x", "--speed", metavar="MULTIPLIER", type=float, default=1, help="replay speed (0 for maximum speed)")
+	replay_parser.add_argument("-l", "--loop", metavar="COUNT", type=int, default=1, help="number of times to replay the capture")
+	replay_parser.add_argument("-t", "--retime", action="store_true", help="replace timestamps with the current time")
+
+	generate_parser = subparsers.add_parser("generate", help="generate readings from virtual meters")
+	generate_parser.add_argument("-n", "--meters", metavar="COUNT", type=int, default=1, help="number of meters")
+	generate_parser.add_argument("-r", "--rate", metavar="HZ", type=float, default=1, help="readings per second from each meter")
+	generate_parser.add_argument("-t", "--time", metavar="SECONDS", type=float, help="stop after this time")
+	generate_parser.add_argument("-b", "--binary", action="store_true", help="send binary datagrams instead of YAML")
+	generate_parser.add_argument("-s", "--seed", metavar="SEED", type=int, help="random number seed")
+
+	for subparser in (replay_parser, generate_parser):
+		subparser.add_argument("-i", "--interface", metavar="INTERFACE", type=str, help="network interface to use")
+		subparser.add_argument("-R", "--receive", action="store_true", help="count readings delivered to a local receiver")
+
+	args = parser.parse_args()
+
+	logging.basicConfig(level=args.debug, format="%(asctime)s.%(msecs)03d  %(levelname)5s  %(message)s", datefmt="%F %T")
+
+	if args.command == "capture":
+		capture(args.filename, args.time, args.count)
+	elif args.command == "replay":
+		replay(args.filename, args.speed, args.interface, args.receive, args.retime, args.loop)
+	else:
+		random.seed(args.seed)
+		generate(args.meters, args.rate, args.time, args.binary, args.interface, args.receive)